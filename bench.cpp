@@ -1,14 +1,106 @@
 #include "aerofoil.hpp"
+#include "fixed_solver.hpp"
+#include "operating_point.hpp"
+#include "performance_map.hpp"
+#include "power_curve.hpp"
+#include "sweep.hpp"
 #include "vawt.hpp"
+#include "wind_series.hpp"
 #include <benchmark/benchmark.h>
+#include <atomic>
 #include <boost/math/constants/constants.hpp>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <math.h>
 #include <memory>
+#include <new>
+#include <random>
+#include <vector>
 
 using namespace vawt;
 const double TO_RAD = boost::math::double_constants::pi / 180;
 
-static std::shared_ptr<Aerofoil> load_naca0018() {
+// heap allocations are counted while `count_allocations` is set. The whole
+// replaceable new/delete family is replaced, all of it backed by
+// malloc/aligned_alloc and free, so every pair matches.
+static std::atomic<bool> count_allocations = false;
+static std::atomic<size_t> allocations = 0;
+
+static void* allocate(size_t size, size_t align = 0) noexcept {
+    if (count_allocations) {
+        allocations++;
+    }
+    size = size ? size : 1;
+    if (align > alignof(std::max_align_t)) {
+        // aligned_alloc needs a multiple of the alignment
+        return std::aligned_alloc(align, (size + align - 1) / align * align);
+    }
+    return std::malloc(size);
+}
+
+static void* allocate_or_throw(size_t size, size_t align = 0) {
+    if (void* p = allocate(size, align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return allocate_or_throw(size); }
+void* operator new[](size_t size) { return allocate_or_throw(size); }
+void* operator new(size_t size, std::align_val_t align) {
+    return allocate_or_throw(size, (size_t)align);
+}
+void* operator new[](size_t size, std::align_val_t align) {
+    return allocate_or_throw(size, (size_t)align);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+void* operator new(size_t size, std::align_val_t align,
+                   const std::nothrow_t&) noexcept {
+    return allocate(size, (size_t)align);
+}
+void* operator new[](size_t size, std::align_val_t align,
+                     const std::nothrow_t&) noexcept {
+    return allocate(size, (size_t)align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+static std::shared_ptr<Aerofoil> load_naca0018(size_t n_alpha = 0,
+                                               size_t n_re = 0,
+                                               bool single = false) {
     vawt::AerofoilBuilder* builder = new vawt::AerofoilBuilder;
     return builder->load_data("examples/NACA0018/NACA0018Re0080.data", 80'000.0)
         .load_data("examples/NACA0018/NACA0018Re0040.data", 40'000.0)
@@ -16,6 +108,8 @@ static std::shared_ptr<Aerofoil> load_naca0018() {
         .set_aspect_ratio(12.8)
         .update_aspect_ratio(true)
         .symmetric(true)
+        .uniform_grid(n_alpha, n_re)
+        .single_precision(single)
         .build();
 }
 
@@ -33,6 +127,23 @@ static void bench_const_beta(benchmark::State& state) {
     }
 }
 
+static void bench_const_beta_polar_view(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    auto testcase = setup_solver(foil);
+    testcase.polar_view(true);
+    for (auto _ : state) {
+        testcase.solve(0.0);
+    }
+}
+
+static void bench_const_beta_single(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33, true);
+    auto testcase = setup_solver(foil);
+    for (auto _ : state) {
+        testcase.solve(0.0);
+    }
+}
+
 static void bench_sin_beta(benchmark::State& state) {
     auto foil = load_naca0018();
     auto testcase = setup_solver(foil);
@@ -41,6 +152,433 @@ static void bench_sin_beta(benchmark::State& state) {
     }
 }
 
+static void bench_sin_beta_function(benchmark::State& state) {
+    auto foil = load_naca0018();
+    auto testcase = setup_solver(foil);
+    std::function<double(double)> beta = [](double theta) {
+        return sin(theta) * 10.0 * TO_RAD;
+    };
+    for (auto _ : state) {
+        testcase.solve(beta);
+    }
+}
+
+static void bench_fourier_beta(benchmark::State& state) {
+    auto foil = load_naca0018();
+    auto testcase = setup_solver(foil);
+    FourierPitch beta(0.0, {}, {10.0 * TO_RAD});
+    for (auto _ : state) {
+        testcase.solve(beta);
+    }
+}
+
+static void bench_const_beta_uniform_grid(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    auto testcase = setup_solver(foil);
+    for (auto _ : state) {
+        testcase.solve(0.0);
+    }
+}
+
+/**
+ * @brief validation accuracy with the root finder `RootFinder(state.range(0))`
+ */
+static void bench_root_finder(benchmark::State& state) {
+    auto foil = load_naca0018();
+    auto testcase = setup_solver(foil);
+    testcase.epsilon(1e-8).root_finder(RootFinder(state.range(0)));
+    for (auto _ : state) {
+        testcase.solve(0.0);
+    }
+}
+
+/**
+ * @brief a Cp-lambda sweep over 100 closely spaced tsr values, with
+ * `continuation(state.range(0))`
+ */
+static void bench_tsr_sweep(benchmark::State& state) {
+    auto foil = load_naca0018();
+    auto testcase = setup_solver(foil);
+    testcase.continuation(state.range(0));
+    for (auto _ : state) {
+        for (int i = 0; i < 100; i++) {
+            testcase.tsr(1.5 + 0.03 * i).solve(0.0);
+        }
+    }
+}
+
+/**
+ * @brief `state.range(0)` streamtubes on the uniform grid foil, solved one by
+ * one or in lockstep with `lockstep(state.range(1))`
+ */
+static void bench_lockstep(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    auto testcase = setup_solver(foil);
+    testcase.n_streamtubes(state.range(0)).lockstep(state.range(1));
+    for (auto _ : state) {
+        testcase.solve(0.0);
+    }
+}
+
+/**
+ * @brief a Cp-lambda curve of 32 tsr values with 36 streamtubes on the
+ * uniform grid foil, by a serial loop of `solve` calls
+ * (`state.range(0) == 0`) or by one `solve_batch` (`state.range(0) == 1`)
+ */
+static void bench_solve_batch(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    auto testcase = setup_solver(foil);
+    testcase.n_streamtubes(36);
+    std::vector<OperatingPoint> points;
+    for (int i = 0; i < 32; i++) {
+        points.push_back({1.5 + 0.1 * i, 50'000.0});
+    }
+    for (auto _ : state) {
+        if (state.range(0)) {
+            testcase.solve_batch(points, 0.0);
+            continue;
+        }
+        for (const OperatingPoint& point : points) {
+            testcase.tsr(point.tsr).re(point.re);
+            testcase.solve(0.0);
+        }
+    }
+}
+
+/**
+ * @brief a Cp-lambda curve on `[1, 5]` with 72 streamtubes, on a uniform grid
+ * of 101 tsr values (`state.range(0) == 0`) or sampled by a
+ * `PowerCurveBuilder` to a tolerance of 1e-4 (`state.range(0) == 1`)
+ */
+static void bench_power_curve(benchmark::State& state) {
+    auto foil = load_naca0018();
+    auto testcase = setup_solver(foil);
+    testcase.epsilon(1e-8);
+    size_t solves = 0;
+    for (auto _ : state) {
+        if (state.range(0)) {
+            auto curve = PowerCurveBuilder(testcase).tolerance(1e-4).build();
+            solves = curve.n_solves();
+            continue;
+        }
+        for (int i = 0; i <= 100; i++) {
+            testcase.tsr(1.0 + 0.04 * i).solve(0.0).c_power();
+        }
+        solves = 101;
+    }
+    state.counters["solves"] = solves;
+}
+
+/**
+ * @brief the tsr of maximum Cp on `[1, 6]` with 72 streamtubes, by a grid
+ * search with a spacing of 0.02 (`state.range(0) == 0`) or by an
+ * `OperatingPointSolver` with a tolerance of 0.01 (`state.range(0) == 1`)
+ */
+static void bench_optimal_tsr(benchmark::State& state) {
+    auto foil = load_naca0018();
+    auto testcase = setup_solver(foil);
+    testcase.epsilon(1e-8);
+    size_t solves = 0;
+    for (auto _ : state) {
+        if (state.range(0)) {
+            auto optimum = OperatingPointSolver(testcase)
+                               .tolerance(0.01)
+                               .optimal_tsr(ConstantPitch(0.0));
+            solves = optimum.solves;
+            continue;
+        }
+        double best = -1.0;
+        for (int i = 0; i <= 250; i++) {
+            auto solution = testcase.tsr(1.0 + 0.02 * i).solve(0.0);
+            best = std::max(best, solution.c_power());
+        }
+        solves = 251;
+    }
+    state.counters["solves"] = solves;
+}
+
+/**
+ * @brief Cp and Cq of 100 operating points spread over tsr `[1, 5]` and re
+ * `[2e4, 1.6e5]`, by direct solves (`state.range(0) == 0`) or by lookups in a
+ * `PerformanceMap` built beforehand (`state.range(0) == 1`), and the annual
+ * energy of a Weibull site from the map (`state.range(0) == 2`)
+ */
+static void bench_performance_map(benchmark::State& state) {
+    auto foil = load_naca0018();
+    auto testcase = setup_solver(foil);
+    auto map = PerformanceMapBuilder(testcase).build();
+    std::vector<double> tsr(100), re(100), c_power(100), c_torque(100);
+    for (size_t i = 0; i < tsr.size(); i++) {
+        tsr[i] = 1.0 + 0.04 * (double)i;
+        re[i] = 20'000.0 * std::pow(8.0, (double)((i * 37) % 100) / 99.0);
+    }
+    YieldSettings site{.area = 2.0, .re_per_speed = 5'000.0, .tsr = 3.0};
+    for (auto _ : state) {
+        if (state.range(0) == 0) {
+            for (size_t i = 0; i < tsr.size(); i++) {
+                auto solution = testcase.tsr(tsr[i]).re(re[i]).solve(0.0);
+                c_power[i] = solution.c_power();
+                c_torque[i] = solution.c_torque();
+            }
+        } else if (state.range(0) == 1) {
+            map.eval(tsr, re, 0.0, c_power, c_torque);
+        } else {
+            benchmark::DoNotOptimize(map.annual_energy(site, 2.0, 7.0));
+        }
+        benchmark::DoNotOptimize(c_power.data());
+    }
+}
+
+/**
+ * @brief a day of 1 Hz wind speeds streamed through a `WindSeriesSimulator`
+ * with lookups in a `PerformanceMap` (`state.range(0) == 0`) or on demand
+ * solves (`state.range(0) == 1`)
+ */
+static void bench_wind_series(benchmark::State& state) {
+    auto foil = load_naca0018();
+    auto testcase = setup_solver(foil);
+    auto record =
+        (std::filesystem::temp_directory_path() / "vawt-bench-wind.bin")
+            .string();
+    {
+        std::ofstream out(record, std::ios::binary);
+        for (int i = 0; i < 86'400; i++) {
+            double speed = 8.0 + 5.0 * std::sin(0.001 * i) +
+                           2.0 * std::sin(0.37 * i);
+            out.write(reinterpret_cast<const char*>(&speed), sizeof(speed));
+        }
+    }
+    YieldSettings rotor{.area = 2.0, .re_per_speed = 5'000.0, .tsr = 3.0};
+    auto simulator = state.range(0)
+                         ? WindSeriesSimulator(testcase)
+                         : WindSeriesSimulator(
+                               PerformanceMapBuilder(testcase).build());
+    simulator.settings(rotor).radius(0.5);
+    size_t solves = 0;
+    for (auto _ : state) {
+        auto summary = simulator.run(record, SeriesFormat::binary,
+                                     [](const SeriesChunk& chunk) {
+                                         benchmark::DoNotOptimize(
+                                             chunk.power.data());
+                                     });
+        solves = summary.solves;
+    }
+    std::filesystem::remove(record);
+    state.counters["solves"] = solves;
+    state.SetItemsProcessed(state.iterations() * 86'400);
+}
+
+/**
+ * @brief repeated solves into the same workspace and solution, with
+ * `lockstep(state.range(0))`
+ *
+ * Fails when a solve allocates memory or leaves a copy of the aerofoil
+ * pointer behind. Copies made and released within a solve can not be seen
+ * from here, the streamtubes take the case by reference instead.
+ */
+static void bench_solve_into(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    auto testcase = setup_solver(foil);
+    testcase.lockstep(state.range(0));
+    std::function<double(double)> beta = [](double) { return 0.0; };
+    VAWTSolver::Workspace workspace;
+    VAWTSolution solution;
+    testcase.solve_into(beta, workspace, solution);
+    long refs = foil.use_count();
+    size_t copies = 0;
+
+    allocations = 0;
+    count_allocations = true;
+    for (auto _ : state) {
+        testcase.solve_into(beta, workspace, solution);
+        copies += foil.use_count() != refs;
+    }
+    count_allocations = false;
+    state.counters["allocations"] = allocations;
+    state.counters["copies"] = copies;
+    if (allocations != 0 || copies != 0) {
+        state.SkipWithError("solve_into allocated or copied the aerofoil");
+    }
+}
+
+/**
+ * @brief repeated solves with `N` streamtubes into the same solution, by the
+ * general `VAWTSolver::solve_into` (`state.range(0) == 0`) or by
+ * `FixedVAWTSolver<N>` (`state.range(0) == 1`)
+ *
+ * Fails when a solve allocates memory.
+ */
+template <uint N> static void bench_fixed(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    auto testcase = setup_solver(foil);
+    testcase.n_streamtubes(N);
+    FixedVAWTSolver<N> fixed(testcase);
+    FixedSolution<N> fixed_solution;
+    VAWTSolver::Workspace workspace;
+    VAWTSolution solution;
+    ConstantPitch beta(0.0);
+    fixed.solve_into(beta, fixed_solution);
+    testcase.solve_into(beta, workspace, solution);
+
+    allocations = 0;
+    count_allocations = true;
+    for (auto _ : state) {
+        if (state.range(0)) {
+            fixed.solve_into(beta, fixed_solution);
+        } else {
+            testcase.solve_into(beta, workspace, solution);
+        }
+    }
+    count_allocations = false;
+    state.counters["allocations"] = allocations;
+    if (allocations != 0) {
+        state.SkipWithError("the solve allocated");
+    }
+}
+
+/**
+ * @brief an optimizer step that changes the pitch on a sector of 0.3 rad with
+ * 360 streamtubes, by a full warm started solve (`state.range(0) == 0`) or
+ * with `resolve` (`state.range(0) == 1`)
+ */
+static void bench_resolve(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    auto testcase = setup_solver(foil);
+    testcase.n_streamtubes(360);
+    auto base = testcase.solve(0.0);
+    auto step = [](double theta) {
+        return (theta > 1.0 && theta < 1.3) ? 0.01 : 0.0;
+    };
+    auto tubes = testcase.streamtubes_between(1.0, 1.3);
+    auto warm = VAWTSolver(testcase).warm_start(base);
+    VAWTSolver::Workspace workspace;
+    VAWTSolution solution = base;
+    solution.c_torque();
+    for (auto _ : state) {
+        if (state.range(0)) {
+            testcase.resolve(step, tubes, solution);
+        } else {
+            warm.solve_into(step, workspace, solution);
+        }
+        double c_torque = solution.c_torque();
+        benchmark::DoNotOptimize(c_torque);
+    }
+}
+
+/**
+ * @brief a single solve with `state.range(0)` streamtubes, serial or split
+ * into tasks with `parallel(state.range(1))`
+ */
+static void bench_parallel_solve(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    auto testcase = setup_solver(foil);
+    testcase.n_streamtubes(state.range(0)).parallel(state.range(1));
+    for (auto _ : state) {
+        testcase.solve(0.0);
+    }
+}
+
+/**
+ * @brief a sweep over 400 cases on a pool with `state.range(0)` threads,
+ * `0` for one per hardware thread
+ */
+static void bench_sweep(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    ThreadPool pool(state.range(0));
+    std::vector<double> tsr;
+    for (int i = 0; i < 100; i++) {
+        tsr.push_back(1.5 + 0.03 * i);
+    }
+    auto runner = SweepRunner(setup_solver(foil));
+    runner.pool(pool).grid(tsr, {31'300.0, 60'000.0}, {0.2, 0.3525}, {72},
+                           {[](double) { return 0.0; }});
+    for (auto _ : state) {
+        runner.run([](size_t, const SweepCase&, VAWTSolution& solution) {
+            benchmark::DoNotOptimize(solution.epsilon());
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * runner.cases().size());
+}
+
+/**
+ * @brief operating points as they occur in a solve: moderate angles of attack
+ * around the turbine reynolds number
+ */
+static void polar_points(size_t n, std::vector<double>& alpha,
+                         std::vector<double>& re) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> alpha_dist(-25.0 * TO_RAD,
+                                                      25.0 * TO_RAD);
+    std::uniform_real_distribution<double> re_dist(60'000.0, 140'000.0);
+    alpha.resize(n);
+    re.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        alpha[i] = alpha_dist(rng);
+        re[i] = re_dist(rng);
+    }
+}
+
+static void bench_cl_cd_scalar(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33);
+    std::vector<double> alpha, re;
+    polar_points(state.range(0), alpha, re);
+    std::vector<double> cl(alpha.size()), cd(alpha.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < alpha.size(); i++) {
+            auto coeffs = foil->cl_cd(alpha[i], re[i]);
+            cl[i] = coeffs.cl();
+            cd[i] = coeffs.cd();
+        }
+        benchmark::DoNotOptimize(cl.data());
+        benchmark::DoNotOptimize(cd.data());
+    }
+}
+
+/**
+ * @brief batched polar lookups of `state.range(0)` points in a double
+ * (`state.range(1) == 0`) or single precision table (`state.range(1) == 1`)
+ */
+static void bench_cl_cd_batch(benchmark::State& state) {
+    auto foil = load_naca0018(361, 33, state.range(1));
+    std::vector<double> alpha, re;
+    polar_points(state.range(0), alpha, re);
+    std::vector<double> cl(alpha.size()), cd(alpha.size());
+    for (auto _ : state) {
+        foil->cl_cd_batch(alpha, re, cl, cd);
+        benchmark::DoNotOptimize(cl.data());
+        benchmark::DoNotOptimize(cd.data());
+    }
+}
+
 BENCHMARK(bench_const_beta);
+BENCHMARK(bench_const_beta_uniform_grid);
+BENCHMARK(bench_const_beta_polar_view);
+BENCHMARK(bench_const_beta_single);
 BENCHMARK(bench_sin_beta);
+BENCHMARK(bench_sin_beta_function);
+BENCHMARK(bench_fourier_beta);
+BENCHMARK(bench_root_finder)
+    ->Arg((int)RootFinder::Bisection)
+    ->Arg((int)RootFinder::Brent)
+    ->Arg((int)RootFinder::Illinois)
+    ->Arg((int)RootFinder::Newton);
+BENCHMARK(bench_tsr_sweep)->Arg(0)->Arg(1);
+BENCHMARK(bench_lockstep)
+    ->ArgsProduct({{36, 72, 360}, {0, 1}});
+BENCHMARK(bench_solve_batch)->Arg(0)->Arg(1);
+BENCHMARK(bench_power_curve)->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(bench_optimal_tsr)->Arg(0)->Arg(1);
+BENCHMARK(bench_performance_map)->Arg(0)->Arg(1)->Arg(2);
+BENCHMARK(bench_wind_series)->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(bench_solve_into)->Arg(0)->Arg(1);
+BENCHMARK(bench_resolve)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(bench_fixed, 36)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(bench_fixed, 72)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(bench_fixed, 144)->Arg(0)->Arg(1);
+BENCHMARK(bench_parallel_solve)
+    ->ArgsProduct({{512, 2'000, 10'000}, {0, 1}})
+    ->UseRealTime();
+BENCHMARK(bench_sweep)->Arg(1)->Arg(2)->Arg(4)->Arg(0)->UseRealTime();
+BENCHMARK(bench_cl_cd_scalar)->Arg(72)->Arg(4096);
+BENCHMARK(bench_cl_cd_batch)->ArgsProduct({{72, 4096}, {0, 1}});
 BENCHMARK_MAIN();
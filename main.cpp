@@ -1,4 +1,5 @@
 #include <boost/math/constants/constants.hpp>
+#include <sweep.hpp>
 #include <vawt.hpp>
 #include <chrono>
 #include <iostream>
@@ -35,5 +36,15 @@ int main(int argc, char** argv) {
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     std::cout << "Duration for 10'000 solutions: " << duration.count() << " microseconds" << std::endl;
 
+    auto runner = SweepRunner(testcase);
+    for (int i = 0; i < 10'000; i++) {
+        runner.add(SweepCase{3.25, 31'300.0, 0.3525, 72, [](double) { return 0.0; }});
+    }
+    start = std::chrono::high_resolution_clock::now();
+    runner.run([](size_t, const SweepCase&, VAWTSolution&) {});
+    end = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    std::cout << "Duration for 10'000 solutions in parallel: " << duration.count() << " microseconds" << std::endl;
+
     return 0;
 }
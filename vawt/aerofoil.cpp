@@ -1,30 +1,29 @@
 #include "aerofoil.hpp"
+#include "polar_cache.hpp"
+#include "polar_file.hpp"
 #include "private_stuff.hpp"
+#include "thread_pool.hpp"
 
 #include <sys/types.h>
 
 #include <Interpolators/_1D/LinearInterpolator.hpp>
 #include <algorithm>
-#include <boost/algorithm/string/trim.hpp>
-#include <boost/lexical_cast.hpp>
 #include <boost/math/constants/constants.hpp>
-#include <boost/range/combine.hpp>
-#include <boost/range/detail/combine_cxx11.hpp>
-#include <boost/tuple/detail/tuple_basic.hpp>
 #include <cassert>
 #include <cmath>
-#include <csv.hpp>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <locale>
 #include <memory>
-#include <set>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <vector>
 
-using namespace csv;
 using namespace std;
 
 namespace vawt {
@@ -33,17 +32,6 @@ const double PI = boost::math::double_constants::pi;
 const double TO_RAD = PI / 180.0;
 const double TO_DEG = 1.0 / TO_RAD;
 
-/**
- * @brief cast a string to double
- *
- * @param s
- * @return double
- */
-double to_double(string s) {
-    boost::algorithm::trim(s);
-    return boost::lexical_cast<double>(s);
-}
-
 struct DataPoint {
     double& alpha;
     double& cl;
@@ -91,32 +79,139 @@ void viterna_corrigan(DataPoint p, DataPoint stall, double ar) {
  * @param set
  */
 void resample_set(DataSet& dataset) {
+    size_t n = 0;
+    for (const DataRow& row : dataset) {
+        n += get<1>(row).size();
+    }
     vector<double> resampled_alpha;
-    for (DataRow& row : dataset) {
-        for (double alpha : get<1>(row)) {
-            resampled_alpha.push_back(alpha);
-        }
+    resampled_alpha.reserve(n);
+    for (const DataRow& row : dataset) {
+        resampled_alpha.insert(resampled_alpha.end(), get<1>(row).begin(),
+                               get<1>(row).end());
     }
     sort(resampled_alpha.begin(), resampled_alpha.end());
     auto u = unique(resampled_alpha.begin(), resampled_alpha.end());
     resampled_alpha.erase(u, resampled_alpha.end());
 
-    for (DataRow& row : dataset) {
-        vector<double>& alpha = get<1>(row);
-        vector<double>& cl = get<2>(row);
-        vector<double>& cd = get<3>(row);
-        _1D::LinearInterpolator<double> cl_interp(alpha, cl);
-        _1D::LinearInterpolator<double> cd_interp(alpha, cd);
-        alpha = resampled_alpha;
-        cl.resize(0);
-        cd.resize(0);
-        for (double x : alpha) {
+    ThreadPool::shared().parallel_for(dataset.size(), [&](size_t k) {
+        DataRow& row = dataset[k];
+        _1D::LinearInterpolator<double> cl_interp(get<1>(row), get<2>(row));
+        _1D::LinearInterpolator<double> cd_interp(get<1>(row), get<3>(row));
+        vector<double> cl, cd;
+        cl.reserve(resampled_alpha.size());
+        cd.reserve(resampled_alpha.size());
+        for (double x : resampled_alpha) {
             cl.push_back(cl_interp(x));
             cd.push_back(cd_interp(x));
         }
+        get<1>(row) = resampled_alpha;
+        get<2>(row) = std::move(cl);
+        get<3>(row) = std::move(cd);
+    });
+}
+
+/**
+ * @brief sample one row of the dataset at evenly spaced alpha values
+ *
+ * The row is interpolated linearly on its own alpha values and held constant
+ * beyond them. Since the sample points are ascending the bracketing interval
+ * is found by walking forward, the whole row is sampled in linear time.
+ *
+ * @param row
+ * @param alpha_0 - first sample point
+ * @param d_alpha - spacing of the sample points
+ * @param alpha_1 - last sample point
+ * @param n_alpha - number of sample points
+ * @param cl - output, n_alpha values
+ * @param cd - output, n_alpha values
+ */
+void sample_row(const DataRow& row, double alpha_0, double d_alpha,
+                double alpha_1, size_t n_alpha, double* cl, double* cd) {
+    const vector<double>& x = get<1>(row);
+    const vector<double>& y_cl = get<2>(row);
+    const vector<double>& y_cd = get<3>(row);
+    size_t k = 0;
+    for (size_t i = 0; i < n_alpha; i++) {
+        double a = clamp(min(alpha_0 + (double)i * d_alpha, alpha_1),
+                         x.front(), x.back());
+        while (k + 2 < x.size() && x[k + 1] <= a) {
+            k++;
+        }
+        if (x.size() == 1 || x[k + 1] == x[k]) {
+            cl[i] = y_cl[k];
+            cd[i] = y_cd[k];
+            continue;
+        }
+        double t = (a - x[k]) / (x[k + 1] - x[k]);
+        cl[i] = y_cl[k] + t * (y_cl[k + 1] - y_cl[k]);
+        cd[i] = y_cd[k] + t * (y_cd[k + 1] - y_cd[k]);
     }
 }
 
+/**
+ * @brief resample a dataset on a uniform alpha / log(re) grid
+ *
+ * The rows may each have their own alpha values. The alpha grid spans all of
+ * them, a row that does not reach as far is held constant at its ends.
+ * Between the rows the data is interpolated linearly in re, just like the
+ * bilinear interpolator does, only the grid points are spaced evenly in
+ * log(re).
+ *
+ * @param dataset
+ * @param n_alpha
+ * @param n_re
+ * @return PolarTable
+ */
+PolarTable uniform_table(const DataSet& dataset, size_t n_alpha, size_t n_re) {
+    vector<double> re;
+    re.reserve(dataset.size());
+    double alpha_0 = numeric_limits<double>::infinity();
+    double alpha_1 = -numeric_limits<double>::infinity();
+    for (const DataRow& row : dataset) {
+        re.push_back(get<0>(row));
+        alpha_0 = min(alpha_0, get<1>(row).front());
+        alpha_1 = max(alpha_1, get<1>(row).back());
+    }
+    double d_alpha = (alpha_1 - alpha_0) / (double)(n_alpha - 1);
+    double log_re_0 = log(re.front());
+    double d_log_re = (log(re.back()) - log_re_0) / (double)(n_re - 1);
+    if (d_log_re == 0.0) {
+        // a single reynolds number, every row is the same
+        d_log_re = 1.0;
+    }
+
+    vector<double> data(2 * n_alpha * n_re);
+    ThreadPool::shared().parallel_for(n_re, [&](size_t j) {
+        double r = clamp(exp(log_re_0 + (double)j * d_log_re), re.front(),
+                         re.back());
+        // bracketing rows k_0, k_1 and the blend factor between them
+        size_t k_0 = 0, k_1 = 0;
+        double t = 0.0;
+        if (re.size() > 1) {
+            k_1 = upper_bound(re.begin(), re.end(), r) - re.begin();
+            k_1 = clamp(k_1, (size_t)1, re.size() - 1);
+            k_0 = k_1 - 1;
+            t = (r - re[k_0]) / (re[k_1] - re[k_0]);
+        }
+        vector<double> samples(4 * n_alpha);
+        double* cl_0 = samples.data();
+        double* cd_0 = cl_0 + n_alpha;
+        double* cl_1 = cd_0 + n_alpha;
+        double* cd_1 = cl_1 + n_alpha;
+        sample_row(dataset[k_0], alpha_0, d_alpha, alpha_1, n_alpha, cl_0,
+                   cd_0);
+        sample_row(dataset[k_1], alpha_0, d_alpha, alpha_1, n_alpha, cl_1,
+                   cd_1);
+        double* out = data.data() + 2 * j * n_alpha;
+        for (size_t i = 0; i < n_alpha; i++) {
+            out[2 * i] = cl_0[i] + t * (cl_1[i] - cl_0[i]);
+            out[2 * i + 1] = cd_0[i] + t * (cd_1[i] - cd_0[i]);
+        }
+    });
+    return PolarTable(alpha_0, d_alpha, log_re_0, d_log_re, n_alpha, n_re,
+                      std::move(data));
+}
+
 std::pair<double, double> ClCd::to_tangential(double alpha, double beta) {
     return rot_vec(this->cl(), -this->cd(), alpha + beta);
 }
@@ -125,24 +220,40 @@ std::pair<double, double> ClCd::to_global(double alpha, double beta,
     return rot_vec(this->cl(), -this->cd(), alpha + beta + theta);
 }
 
-DataSet AerofoilBuilder::transformed_set() {
-    if (!this->_update_aspect_ratio) {
-        return this->data;
+void Aerofoil::cl_cd_batch(span<const double> alpha, span<const double> re,
+                           span<double> cl, span<double> cd) const {
+    if (alpha.size() != re.size() || alpha.size() != cl.size() ||
+        alpha.size() != cd.size()) {
+        throw "cl_cd_batch: all spans must have the same size";
     }
-
-    if (this->aspect_ratio >= 98.0) {
-        return this->data;
+    if (this->table && !this->smooth) {
+        this->table->eval(alpha.data(), re.data(), cl.data(), cd.data(),
+                          alpha.size(), this->symmetric);
+        return;
+    }
+    if (this->single_table) {
+        this->single_table->eval(alpha.data(), re.data(), cl.data(),
+                                 cd.data(), alpha.size(), this->symmetric);
+        return;
     }
+    for (size_t i = 0; i < alpha.size(); i++) {
+        auto coeffs = this->cl_cd(alpha[i], re[i]);
+        cl[i] = coeffs.cl();
+        cd[i] = coeffs.cd();
+    }
+}
 
-    DataSet set;
-    for (DataRow row : this->data) {
-        this->transform_row(row);
-        set.push_back(row);
+DataSet AerofoilBuilder::transformed_set() const {
+    DataSet set = this->data;
+    if (!this->needs_transform()) {
+        return set;
     }
+    ThreadPool::shared().parallel_for(
+        set.size(), [&](size_t i) { this->transform_row(set[i]); });
     return set;
 }
 
-void AerofoilBuilder::transform_row(DataRow& row) {
+void AerofoilBuilder::transform_row(DataRow& row) const {
     if (!this->_symmetric) {
         throw "aspect ratio correction for asymetric profiles is not "
               "implemented";
@@ -163,7 +274,6 @@ void AerofoilBuilder::transform_row(DataRow& row) {
     if (stall_idx == -1) {
         throw "stall point not found!";
     }
-    DataPoint stall{alpha[stall_idx], cl[stall_idx], cd[stall_idx]};
 
     // above the stall point we calculate the data for each degree up to 90
     int len = stall_idx + 90 + 1 - floor(alpha[stall_idx] * TO_DEG);
@@ -173,6 +283,8 @@ void AerofoilBuilder::transform_row(DataRow& row) {
     alpha.reserve(len);
     cl.reserve(len);
     cd.reserve(len);
+    // taken after the reserve, which may move the data
+    DataPoint stall{alpha[stall_idx], cl[stall_idx], cd[stall_idx]};
 
     for (int i = stall_idx + 1; i < len; i++) {
         alpha.push_back(TO_RAD * (double)i);
@@ -187,61 +299,209 @@ void AerofoilBuilder::add_data(DataRow data) {
     double re = get<0>(data);
     auto it = lower_bound(
         this->data.begin(), this->data.end(), re,
-        [](const std::tuple<double, std::vector<double>, std::vector<double>,
-                            std::vector<double>>& tuple,
-           double value) { return std::get<0>(tuple) < value; });
-    this->data.insert(it, data);
+        [](const DataRow& row, double value) { return get<0>(row) < value; });
+    this->data.insert(it, std::move(data));
 }
 
 AerofoilBuilder& AerofoilBuilder::load_data(string_view file, double re) {
-    CSVFormat format;
-    format.no_header().delimiter(',');
-    unique_ptr<CSVReader> reader(new CSVReader(file, format));
     if (this->contains_re(re)) {
         throw "data is already loaded";
     }
+    this->sources.push_back(pair(string(file), re));
+    return *this;
+}
 
-    vector<double> alpha, cl, cd;
-
-    for (CSVRow& row : *reader) {
-        assert(row.size() == 3);
-        auto iter = row.begin();
-        alpha.push_back(to_double(iter->get()) * TO_RAD);
-        iter++;
-        cl.push_back(to_double(iter->get()));
-        iter++;
-        cd.push_back(to_double(iter->get()));
+AerofoilBuilder& AerofoilBuilder::load_directory(string_view dir,
+                                                 string_view prefix,
+                                                 double re_scale) {
+    vector<string> files;
+    for (auto& entry : filesystem::directory_iterator(dir)) {
+        string name = entry.path().filename().string();
+        if (entry.is_regular_file() && name.starts_with(prefix)) {
+            files.push_back(entry.path().string());
+        }
+    }
+    // directory order is unspecified, keep builds reproducible
+    sort(files.begin(), files.end());
+    for (string& file : files) {
+        double re = re_from_filename(file) * re_scale;
+        if (!isnan(re) && this->contains_re(re)) {
+            throw "data is already loaded";
+        }
+        this->sources.push_back(pair(file, re));
     }
-    this->add_data(tuple(re, alpha, cl, cd));
     return *this;
 }
 
+/**
+ * @brief hash of a source file, like `ContentHash::add_file` followed by its
+ * reynolds number
+ *
+ * @param text - content of the file
+ * @param re
+ * @return uint64_t
+ */
+static uint64_t source_hash(string_view text, double re) {
+    return ContentHash().add((uint64_t)text.size()).add(text).add(re).value();
+}
+
+void AerofoilBuilder::read_sources() {
+    vector<DataRow> rows(this->sources.size());
+    vector<uint64_t> hashes(this->sources.size());
+    ThreadPool::shared().parallel_for(this->sources.size(), [&](size_t i) {
+        ifstream in{this->sources[i].first, ios::binary};
+        if (!in) {
+            throw "could not read polar source file";
+        }
+        string text((istreambuf_iterator<char>(in)),
+                    istreambuf_iterator<char>());
+        rows[i] = parse_polar(text);
+        hashes[i] = source_hash(text, this->sources[i].second);
+    });
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        double re = this->sources[i].second;
+        if (isnan(re)) {
+            re = get<0>(rows[i]);
+        }
+        if (isnan(re)) {
+            throw "reynolds number of polar file is unknown";
+        }
+        get<0>(rows[i]) = re;
+        if (find_if(this->data.begin(), this->data.end(),
+                    [re](const DataRow& row) { return get<0>(row) == re; }) !=
+            this->data.end()) {
+            throw "data is already loaded";
+        }
+        this->add_data(std::move(rows[i]));
+        this->read_hash.add(hashes[i]);
+    }
+    this->sources.clear();
+}
+
+uint64_t AerofoilBuilder::content_hash() {
+    // the sources read so far are in `read_hash`, the others are hashed the
+    // same way
+    ContentHash hash = this->read_hash;
+    for (auto& [file, re] : this->sources) {
+        hash.add(ContentHash().add_file(file).add(re).value());
+    }
+    return hash.add((uint64_t)this->_symmetric)
+        .add((uint64_t)this->_update_aspect_ratio)
+        .add(this->aspect_ratio)
+        .add((uint64_t)this->n_alpha_uniform)
+        .add((uint64_t)this->n_re_uniform)
+        .value();
+}
+
+shared_ptr<Aerofoil> AerofoilBuilder::from_cache(string_view file) {
+    auto cache = map_polar_cache(file);
+    if (!cache) {
+        throw "not a valid polar cache file";
+    }
+    return shared_ptr<Aerofoil>(
+        new Aerofoil(std::move(cache->table), cache->symmetric));
+}
+
 shared_ptr<Aerofoil> AerofoilBuilder::build() {
-    DataSet data = this->transformed_set();
+    if (this->_single_precision &&
+        (this->n_alpha_uniform == 0 || this->_smooth)) {
+        throw "single precision requires a uniform grid without smoothing";
+    }
+    uint64_t hash = 0;
+    if (!this->cache.empty()) {
+        if (this->n_alpha_uniform == 0) {
+            throw "a polar cache requires a uniform grid";
+        }
+        if (this->_smooth) {
+            throw "a polar cache can not store a smooth polar";
+        }
+        hash = this->content_hash();
+        auto cache = map_polar_cache(this->cache);
+        if (cache && cache->hash == hash &&
+            cache->symmetric == this->_symmetric) {
+            if (this->_single_precision) {
+                return shared_ptr<Aerofoil>(new Aerofoil(
+                    SinglePolarTable(cache->table), cache->symmetric));
+            }
+            return shared_ptr<Aerofoil>(
+                new Aerofoil(std::move(cache->table), cache->symmetric));
+        }
+    }
+
+    this->read_sources();
+    if (this->data.empty()) {
+        throw "no aerofoil data loaded";
+    }
+    bool bilinear = this->n_alpha_uniform == 0 || this->_smooth;
+    // without a transform the table is sampled straight from this->data, the
+    // dataset is only copied when it has to be changed
+    DataSet data;
+    if (this->needs_transform()) {
+        data = this->transformed_set();
+    } else if (bilinear) {
+        data = this->data;
+    }
+    const DataSet& rows = this->needs_transform() ? data : this->data;
+
+    optional<PolarTable> table;
+    if (this->n_alpha_uniform != 0) {
+        table = uniform_table(rows, this->n_alpha_uniform, this->n_re_uniform);
+        if (!this->cache.empty()) {
+            write_polar_cache(this->cache, hash, this->_symmetric, *table);
+        }
+    }
+    if (!bilinear && this->_single_precision) {
+        return shared_ptr<Aerofoil>(
+            new Aerofoil(SinglePolarTable(*table), this->_symmetric));
+    }
+    if (!bilinear) {
+        return shared_ptr<Aerofoil>(
+            new Aerofoil(std::move(*table), this->_symmetric));
+    }
+
+    // the bilinear interpolator and the smooth polar need a common alpha grid
     resample_set(data);
+    const vector<double>& alpha_grid = get<1>(data.front());
+    size_t n_alpha = alpha_grid.size();
 
-    // duplicate highest and lowest values for extrapolation over re
-    auto lowest = data.front();
-    get<0>(lowest) = 0.0;
-    data.push_front(lowest);
-    auto highest = data.back();
-    get<0>(highest) = numeric_limits<double>::max();
-    data.push_back(highest);
+    optional<SmoothPolar> smooth;
+    if (this->_smooth) {
+        vector<double> re, cl, cd;
+        re.reserve(data.size());
+        cl.reserve(data.size() * n_alpha);
+        cd.reserve(data.size() * n_alpha);
+        for (const DataRow& row : data) {
+            re.push_back(get<0>(row));
+            cl.insert(cl.end(), get<2>(row).begin(), get<2>(row).end());
+            cd.insert(cd.end(), get<3>(row).begin(), get<3>(row).end());
+        }
+        smooth = SmoothPolar(alpha_grid, re, cl, cd);
+    }
 
-    // collect everything into coniguous vectors for the interpolator
+    // collect everything into coniguous vectors for the interpolator, the
+    // highest and lowest rows are repeated for extrapolation over re
     vector<double> alpha, re, cl, cd;
-    for (auto dataset : data) {
-        for (auto datapoint : boost::range::combine(
-                 get<1>(dataset), get<2>(dataset), get<3>(dataset))) {
-            double _alpha, _cl, _cd;
-            boost::tie(_alpha, _cl, _cd) = datapoint;
-            re.push_back(get<0>(dataset));
-            alpha.push_back(_alpha);
-            cl.push_back(_cl);
-            cd.push_back(_cd);
-        }
+    size_t n = (data.size() + 2) * n_alpha;
+    alpha.reserve(n);
+    re.reserve(n);
+    cl.reserve(n);
+    cd.reserve(n);
+    auto append = [&](const DataRow& row, double r) {
+        alpha.insert(alpha.end(), get<1>(row).begin(), get<1>(row).end());
+        re.insert(re.end(), get<1>(row).size(), r);
+        cl.insert(cl.end(), get<2>(row).begin(), get<2>(row).end());
+        cd.insert(cd.end(), get<3>(row).begin(), get<3>(row).end());
+    };
+    append(data.front(), 0.0);
+    for (const DataRow& row : data) {
+        append(row, get<0>(row));
     }
-    return shared_ptr<Aerofoil>(
-        new Aerofoil(alpha, re, cl, cd, this->_symmetric));
+    append(data.back(), numeric_limits<double>::max());
+    data = DataSet();
+
+    return shared_ptr<Aerofoil>(new Aerofoil(
+        std::move(alpha), std::move(re), std::move(cl), std::move(cd),
+        this->_symmetric, std::move(table), std::move(smooth)));
 }
-} // namespace vawt
\ No newline at end of file
+} // namespace vawt
@@ -1,17 +1,60 @@
 #ifndef AEROFOIL_HPP
 #define AEROFOIL_HPP
 
+#include "polar_cache.hpp"
+#include "polar_table.hpp"
+#include "smooth_polar.hpp"
 #include <Interpolators/_2D/BilinearInterpolator.hpp>
-#include <list>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
 namespace vawt {
 class AerofoilBuilder;
 class Aerofoil;
+class PolarView;
 using DataRow = std::tuple<double, std::vector<double>, std::vector<double>,
                            std::vector<double>>;
-using DataSet = std::list<DataRow>;
+using DataSet = std::vector<DataRow>;
+
+/**
+ * @brief symmetry policy for symmetric profiles
+ *
+ * The polar only holds positive angles of attack, cl is odd and cd is even in
+ * alpha.
+ */
+struct Symmetric {
+    static constexpr bool symmetric = true;
+
+    /**
+     * @brief fold alpha onto the positive half of the polar
+     *
+     * @param alpha - updated in place
+     * @return double - the sign to apply to cl
+     */
+    static double fold(double& alpha) {
+        double sgn = std::copysign(1.0, alpha);
+        alpha = std::fabs(alpha);
+        return sgn;
+    }
+};
+
+/**
+ * @brief symmetry policy for asymmetric profiles, the polar covers all angles
+ * of attack
+ */
+struct Asymmetric {
+    static constexpr bool symmetric = false;
+    static double fold(double&) { return 1.0; }
+};
 
 /**
  * @brief Aerofoil coefficients of lift and drag
@@ -19,6 +62,7 @@ using DataSet = std::list<DataRow>;
  */
 class ClCd {
     friend Aerofoil;
+    friend PolarView;
 
   private:
     double _cl;
@@ -64,48 +108,279 @@ class ClCd {
                                         double theta);
 };
 
+/**
+ * @brief Aerofoil coefficients of lift and drag with their first derivatives
+ *
+ */
+class ClCdGrad {
+    friend Aerofoil;
+
+  private:
+    std::array<double, 6> values;
+    ClCdGrad(std::array<double, 6> values) : values(values) {}
+
+  public:
+    /**
+     * @brief Coefficient of Lift
+     *
+     * @return double
+     */
+    double cl() { return this->values[0]; }
+
+    /**
+     * @brief Coefficient of Drag
+     *
+     * @return double
+     */
+    double cd() { return this->values[1]; }
+
+    /**
+     * @brief derivative of the lift coefficient by alpha (per radian)
+     *
+     * @return double
+     */
+    double dcl_dalpha() { return this->values[2]; }
+
+    /**
+     * @brief derivative of the drag coefficient by alpha (per radian)
+     *
+     * @return double
+     */
+    double dcd_dalpha() { return this->values[3]; }
+
+    /**
+     * @brief derivative of the lift coefficient by the reynolds number
+     *
+     * @return double
+     */
+    double dcl_dre() { return this->values[4]; }
+
+    /**
+     * @brief derivative of the drag coefficient by the reynolds number
+     *
+     * @return double
+     */
+    double dcd_dre() { return this->values[5]; }
+
+    /**
+     * @brief the coefficients of `cl_cd` at `(alpha, re)` with central
+     * finite difference derivatives
+     *
+     * @tparam Fn - `ClCd(double alpha, double re)`
+     * @param cl_cd
+     * @param alpha
+     * @param re
+     * @return ClCdGrad
+     */
+    template <class Fn>
+    static ClCdGrad central(const Fn& cl_cd, double alpha, double re) {
+        const double h_alpha = 1e-4;
+        const double h_re = 1e-4 * re;
+        ClCd c = cl_cd(alpha, re);
+        ClCd a_0 = cl_cd(alpha - h_alpha, re);
+        ClCd a_1 = cl_cd(alpha + h_alpha, re);
+        ClCd r_0 = cl_cd(alpha, re - h_re);
+        ClCd r_1 = cl_cd(alpha, re + h_re);
+        return ClCdGrad({c.cl(), c.cd(),
+                         (a_1.cl() - a_0.cl()) / (2 * h_alpha),
+                         (a_1.cd() - a_0.cd()) / (2 * h_alpha),
+                         (r_1.cl() - r_0.cl()) / (2 * h_re),
+                         (r_1.cd() - r_0.cd()) / (2 * h_re)});
+    }
+};
+
 class Aerofoil {
     friend AerofoilBuilder;
+    friend PolarView;
 
   private:
     bool symmetric;
     _2D::BilinearInterpolator<double> cl;
     _2D::BilinearInterpolator<double> cd;
+    std::optional<PolarTable> table;
+    std::optional<SinglePolarTable> single_table;
+    std::optional<SmoothPolar> smooth;
+    std::pair<double, double> alpha_range;
     Aerofoil(std::vector<double> alpha, std::vector<double> re,
-             std::vector<double> cl, std::vector<double> cd, bool symmetric) {
+             std::vector<double> cl, std::vector<double> cd, bool symmetric,
+             std::optional<PolarTable> table,
+             std::optional<SmoothPolar> smooth) {
         this->cl.setData(re, alpha, cl);
         this->cd.setData(re, alpha, cd);
         this->symmetric = symmetric;
+        this->table = std::move(table);
+        this->smooth = std::move(smooth);
+        auto [min, max] = std::minmax_element(alpha.begin(), alpha.end());
+        this->alpha_range = std::pair(*min, *max);
+    }
+    Aerofoil(PolarTable table, bool symmetric) {
+        this->symmetric = symmetric;
+        this->alpha_range = std::pair(
+            table.alpha_0(),
+            table.alpha_0() + table.d_alpha() * (double)(table.n_alpha() - 1));
+        this->table = std::move(table);
+    }
+    Aerofoil(SinglePolarTable table, bool symmetric) {
+        this->symmetric = symmetric;
+        this->alpha_range = std::pair(
+            table.alpha_0(),
+            table.alpha_0() + table.d_alpha() * (double)(table.n_alpha() - 1));
+        this->single_table = std::move(table);
     }
 
   public:
     /**
      * @brief lift and drag coefficients
      *
+     * When the aerofoil was built smooth the coefficients come from the
+     * `SmoothPolar`. Otherwise, when it was built with a uniform grid both
+     * coefficients are read from the fused `PolarTable` in a single lookup.
+     *
      * @param alpha
      * @param re
      * @return ClCd
      */
-    ClCd cl_cd(double alpha, double re) {
-        double cl, cd;
+    ClCd cl_cd(double alpha, double re) const {
         if (this->symmetric) {
-            double sgn = (alpha >= 0) ? 1 : -1;
-            cl = this->cl(re, abs(alpha)) * sgn;
-            cd = this->cd(re, abs(alpha));
-        } else {
-            cl = this->cl(re, alpha);
-            cd = this->cd(re, alpha);
+            return this->cl_cd<Symmetric>(alpha, re);
         }
-        return ClCd(cl, cd);
+        return this->cl_cd<Asymmetric>(alpha, re);
     }
+
+    /**
+     * @brief lift and drag coefficients with the symmetry known at compile
+     * time
+     *
+     * `Symmetry` must be `Symmetric` or `Asymmetric` matching
+     * `is_symmetric()`. The symmetric fold is then compiled in, which lets
+     * the solver inline the lookup into its inner loop without branching on
+     * the symmetry.
+     *
+     * @tparam Symmetry
+     * @param alpha
+     * @param re
+     * @return ClCd
+     */
+    template <class Symmetry> ClCd cl_cd(double alpha, double re) const {
+        assert(Symmetry::symmetric == this->symmetric);
+        double sgn = Symmetry::fold(alpha);
+        if (this->smooth) {
+            auto [cl, cd] = (*this->smooth)(alpha, re);
+            return ClCd(cl * sgn, cd);
+        }
+        if (this->table) {
+            auto [cl, cd] = (*this->table)(alpha, re);
+            return ClCd(cl * sgn, cd);
+        }
+        if (this->single_table) {
+            auto [cl, cd] = (*this->single_table)(alpha, re);
+            return ClCd(cl * sgn, cd);
+        }
+        return ClCd(this->cl(re, alpha) * sgn, this->cd(re, alpha));
+    }
+
+    /**
+     * @brief lift and drag coefficients and their derivatives by alpha and re
+     *
+     * With a smooth aerofoil the derivatives are analytic and continuous.
+     * The other representations are only piecewise linear, for them the
+     * derivatives are central finite differences of `cl_cd`.
+     *
+     * @param alpha
+     * @param re
+     * @return ClCdGrad
+     */
+    ClCdGrad cl_cd_grad(double alpha, double re) const {
+        if (this->symmetric) {
+            return this->cl_cd_grad<Symmetric>(alpha, re);
+        }
+        return this->cl_cd_grad<Asymmetric>(alpha, re);
+    }
+
+    /**
+     * @brief `cl_cd_grad` with the symmetry known at compile time, the
+     * derivatives of exactly the function `cl_cd<Symmetry>` evaluates
+     *
+     * @tparam Symmetry
+     * @param alpha
+     * @param re
+     * @return ClCdGrad
+     */
+    template <class Symmetry>
+    ClCdGrad cl_cd_grad(double alpha, double re) const {
+        assert(Symmetry::symmetric == this->symmetric);
+        if (this->smooth) {
+            double sgn = Symmetry::fold(alpha);
+            auto [cl, cd, dcl_da, dcd_da, dcl_dre, dcd_dre] =
+                this->smooth->derivatives(alpha, re);
+            // cl is odd and cd even in alpha for symmetric profiles
+            return ClCdGrad({cl * sgn, cd, dcl_da, dcd_da * sgn,
+                             dcl_dre * sgn, dcd_dre});
+        }
+        return ClCdGrad::central(
+            [this](double alpha, double re) {
+                return this->cl_cd<Symmetry>(alpha, re);
+            },
+            alpha, re);
+    }
+
+    /**
+     * @brief lift and drag coefficients for many points at once
+     *
+     * With a uniform grid the points are evaluated by a vectorized lookup in
+     * the `PolarTable`, otherwise this falls back to calling `cl_cd` for each
+     * point. All spans must have the same size.
+     *
+     * @param alpha - angles of attack in radians
+     * @param re - reynolds numbers
+     * @param cl - output lift coefficients
+     * @param cd - output drag coefficients
+     */
+    void cl_cd_batch(std::span<const double> alpha, std::span<const double> re,
+                     std::span<double> cl, std::span<double> cd) const;
+
+    /**
+     * @brief the uniform grid table, if the aerofoil was built with one
+     *
+     * @return const PolarTable*
+     */
+    const PolarTable* polar_table() const {
+        return this->table ? &*this->table : nullptr;
+    }
+
+    /**
+     * @brief the uniform grid table, if the aerofoil was built with one in
+     * single precision
+     *
+     * @return const SinglePolarTable*
+     */
+    const SinglePolarTable* single_polar_table() const {
+        return this->single_table ? &*this->single_table : nullptr;
+    }
+
+    /**
+     * @brief is the aerofoil profile symmetric
+     *
+     * @return true
+     * @return false
+     */
+    bool is_symmetric() const { return this->symmetric; }
 };
 
 class AerofoilBuilder {
   private:
     DataSet data;
+    std::vector<std::pair<std::string, double>> sources;
+    // hash of the sources already read into `data`
+    ContentHash read_hash;
+    std::string cache;
     bool _symmetric = false;
     bool _update_aspect_ratio = false;
+    bool _smooth = false;
     double aspect_ratio = std::numeric_limits<double>::infinity();
+    size_t n_alpha_uniform = 0;
+    size_t n_re_uniform = 0;
+    bool _single_precision = false;
 
     /**
      * @brief is data for the reynodlsnumber available?
@@ -118,9 +393,31 @@ class AerofoilBuilder {
         return find_if(this->data.begin(), this->data.end(),
                        [re](const DataRow& tuple) {
                            return std::get<0>(tuple) == re;
-                       }) != this->data.end();
+                       }) != this->data.end() ||
+               find_if(this->sources.begin(), this->sources.end(),
+                       [re](const std::pair<std::string, double>& source) {
+                           return source.second == re;
+                       }) != this->sources.end();
     }
 
+    /**
+     * @brief parse all files passed to `load_data` or `load_directory` that
+     * are not yet in `this.data`
+     *
+     * The files are read and parsed in parallel on the shared thread pool.
+     */
+    void read_sources();
+
+    /**
+     * @brief content hash of all source files and the builder settings
+     *
+     * The same before and after the sources are read, each file is hashed
+     * once.
+     *
+     * @return uint64_t
+     */
+    uint64_t content_hash();
+
     /**
      * @brief adds a datarow to `this.data`
      *
@@ -134,9 +431,23 @@ class AerofoilBuilder {
      * @brief create a new dataset with transformed datapoints for aspect ratio
      * correction
      *
+     * The rows are independent of each other and transformed in parallel on
+     * the shared thread pool.
+     *
      * @return DataSet
      */
-    DataSet transformed_set();
+    DataSet transformed_set() const;
+
+    /**
+     * @brief does `build` need to transform the data for aspect ratio
+     * correction
+     *
+     * @return true
+     * @return false
+     */
+    bool needs_transform() const {
+        return this->_update_aspect_ratio && this->aspect_ratio < 98.0;
+    }
 
     /**
      * @brief transform the datapoints in the row for aspect ratio correction
@@ -144,14 +455,18 @@ class AerofoilBuilder {
      * @param row
      * @return DataRow
      */
-    void transform_row(DataRow& row);
+    void transform_row(DataRow& row) const;
 
   public:
     /**
      * @brief load aerofoil data for a given reynolds number from a file
      *
      * The file is expected to be in csv format delimited by `,` without a
-     * header. It should contain 3 columns: alpha (in degrees), cl, cd
+     * header. It should contain 3 columns: alpha (in degrees), cl, cd.
+     * XFOIL polars and QBlade polar exports are accepted as well.
+     *
+     * The file is only read when the aerofoil is built, and not at all when
+     * the build is served from an up to date cache file.
      *
      * @param file - the file path
      * @param re - the reynoldsnumber for the data
@@ -159,6 +474,27 @@ class AerofoilBuilder {
      */
     AerofoilBuilder& load_data(std::string_view file, double re);
 
+    /**
+     * @brief load aerofoil data from every file in a directory
+     *
+     * Each file holds the data for one reynolds number. Plain csv files (see
+     * `load_data`), XFOIL polars and QBlade polar exports are accepted. The
+     * reynolds number is taken from the file name (`NACA0018Re0080.data` with
+     * `re_scale = 1000` results in `80'000`) or, when the name does not
+     * contain one, from the file header.
+     *
+     * Like with `load_data` the files are only read when the aerofoil is
+     * built, then all of them are parsed in parallel.
+     *
+     * @param dir - the directory
+     * @param prefix - only files whose name starts with it are loaded
+     * @param re_scale - factor applied to the reynolds number in the file name
+     * @return AerofoilBuilder&
+     */
+    AerofoilBuilder& load_directory(std::string_view dir,
+                                    std::string_view prefix = "",
+                                    double re_scale = 1.0);
+
     /**
      * @brief is the aerofoil profile symmetric
      *
@@ -200,6 +536,91 @@ class AerofoilBuilder {
         return *this;
     }
 
+    /**
+     * @brief resample the polar on a uniform alpha / log(re) grid when it is
+     * built
+     *
+     * The built Aerofoil then evaluates lift and drag through a fused
+     * `PolarTable` with index arithmetic instead of searching the non-uniform
+     * grid. The alpha grid spans the range of the (aspect ratio corrected)
+     * data, the reynolds grid spans the loaded reynolds numbers. `n_alpha = 0`
+     * disables the uniform grid.
+     *
+     * Each reynolds slice is interpolated on its own alpha values, the slices
+     * need not share an alpha grid. Unless the aerofoil is also built
+     * `smooth`, the table is all it stores.
+     *
+     * @param n_alpha - number of alpha grid points
+     * @param n_re - number of reynolds grid points
+     * @return AerofoilBuilder&
+     */
+    AerofoilBuilder& uniform_grid(size_t n_alpha, size_t n_re) {
+        if (n_alpha != 0 && (n_alpha < 2 || n_re < 2)) {
+            throw "a uniform grid needs at least 2 points per axis";
+        }
+        this->n_alpha_uniform = n_alpha;
+        this->n_re_uniform = n_re;
+        return *this;
+    }
+
+    /**
+     * @brief store the coefficients of the uniform grid in single precision
+     *
+     * The built aerofoil then evaluates lift and drag through a
+     * `SinglePolarTable`, which takes half the memory of the double precision
+     * table. A polar cache file still holds the table in double precision, it
+     * is converted when loaded. Requires a `uniform_grid` and can not be
+     * combined with `smooth`.
+     *
+     * @param yes
+     * @return AerofoilBuilder&
+     */
+    AerofoilBuilder& single_precision(bool yes) {
+        this->_single_precision = yes;
+        return *this;
+    }
+
+    /**
+     * @brief cache the built polar in a binary file
+     *
+     * When the file exists and was written from the same source files with
+     * the same settings, `build` memory maps it instead of parsing and
+     * transforming the data again. Otherwise the aerofoil is built from the
+     * sources and the file is (re)written. Requires a `uniform_grid`.
+     *
+     * @param file
+     * @return AerofoilBuilder&
+     */
+    AerofoilBuilder& cache_file(std::string_view file) {
+        this->cache = file;
+        return *this;
+    }
+
+    /**
+     * @brief load an Aerofoil from a cache file written by `build`
+     *
+     * The file is memory mapped and used without copying, no check against
+     * the source files is done.
+     *
+     * @param file
+     * @return std::shared_ptr<Aerofoil>
+     */
+    static std::shared_ptr<Aerofoil> from_cache(std::string_view file);
+
+    /**
+     * @brief represent the polar by a smooth (C1) monotone cubic surface
+     *
+     * The built aerofoil then has continuous derivatives by alpha and re,
+     * which `cl_cd_grad` returns analytically. See `SmoothPolar`.
+     *
+     * @param yes
+     * @return AerofoilBuilder&
+     */
+    AerofoilBuilder& smooth(bool yes) {
+        this->_smooth = yes;
+        return *this;
+    }
+
     /**
      * @brief build the Aerofoil
      *
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "streamtube.hpp"
+#include "vawt.hpp"
+#include <algorithm>
+#include <array>
+#include <boost/math/constants/constants.hpp>
+#include <cmath>
+#include <span>
+
+namespace vawt {
+
+/**
+ * @brief location of each of `N` streamtubes in radians, computed at compile
+ * time the same way as `RotorGeometry`
+ *
+ * @tparam N - number of streamtubes
+ * @return std::array<double, N>
+ */
+template <uint N> constexpr std::array<double, N> fixed_theta() {
+    std::array<double, N> theta{};
+    double d_t_half = boost::math::double_constants::pi / (double)N;
+    double d_t = 2.0 * d_t_half;
+    double current = d_t_half;
+    for (size_t i = 0; i < N; i++) {
+        theta[i] = current;
+        current += d_t;
+    }
+    return theta;
+}
+
+/**
+ * @brief the solution of a `FixedVAWTSolver`, stored inline without any
+ * heap memory
+ *
+ * Results are accessed by streamtube index, in the order of increasing
+ * theta.
+ *
+ * @tparam N - number of streamtubes
+ */
+template <uint N> class FixedSolution {
+    friend FixedVAWTSolver<N>;
+
+  private:
+    VAWTCase case_{};
+    std::array<double, N> _beta{};
+    std::array<TubeResult, N> _results{};
+
+    /**
+     * @brief torque of the streamtube `i` at the location `theta`, see
+     * `VAWTSolution::c_torque`
+     */
+    double torque(double theta, size_t i) const {
+        StreamTube tube(theta, this->_beta[i], this->a_0(i));
+        StreamTubeSolution solution(this->case_, tube, this->_results[i].a);
+        return solution.c_tan() * pow(solution.w(), 2);
+    }
+
+  public:
+    /**
+     * @brief location of the streamtube `i` in radians
+     *
+     * @param i
+     * @return double
+     */
+    double theta(size_t i) const { return FixedVAWTSolver<N>::THETA[i]; }
+
+    /**
+     * @brief the pitch angle of the streamtube `i`
+     *
+     * @param i
+     * @return double
+     */
+    double beta(size_t i) const { return this->_beta[i]; }
+
+    /**
+     * @brief the induction factor of the streamtube `i`
+     *
+     * @param i
+     * @return double
+     */
+    double a(size_t i) const { return this->_results[i].a; }
+
+    /**
+     * @brief the upstream induction factor of the streamtube `i`
+     *
+     * @param i
+     * @return double
+     */
+    double a_0(size_t i) const {
+        return (i < N / 2) ? 0.0 : this->_results[N - 1 - i].a;
+    }
+
+    /**
+     * @brief induction factor, iterations and convergence of each streamtube
+     *
+     * @return const std::array<TubeResult, N>&
+     */
+    const std::array<TubeResult, N>& results() const {
+        return this->_results;
+    }
+
+    /**
+     * @brief number of streamtubes that reached the iteration limit
+     *
+     * @return uint
+     */
+    uint n_unconverged() const {
+        return std::count_if(
+            this->_results.begin(), this->_results.end(),
+            [](const TubeResult& result) { return !result.converged; });
+    }
+
+    /**
+     * @brief Torque ceofficient of the turbine, the same as
+     * `VAWTSolution::c_torque` of the same solve
+     *
+     * @return double
+     */
+    double c_torque() const {
+        const double two_pi = boost::math::double_constants::two_pi;
+        // the periodic padding of `VAWTSolution` on both ends is summed too
+        double ct = this->torque(this->theta(N - 1) - two_pi, N - 1);
+        for (size_t i = 0; i < N; i++) {
+            ct += this->torque(this->theta(i), i);
+        }
+        ct += this->torque(this->theta(0) + two_pi, 0);
+        return ct * this->case_.solidity / (double)N;
+    }
+
+    /**
+     * @brief Power coefficient of the turbine
+     *
+     * @return double
+     */
+    double c_power() const { return this->c_torque() * this->case_.tsr; }
+};
+
+/**
+ * @brief a solver for a number of streamtubes `N` fixed at compile time
+ *
+ * The theta grid is a compile time constant and the trigonometry of each
+ * location is tabulated once per `N`. Solutions are `std::array`s, a solve
+ * uses no heap memory. The pair loop has a constant trip count, so the
+ * compiler can unroll it.
+ *
+ * The settings are those of a `VAWTSolver`, see `settings`. A solve gives
+ * the same results as `VAWTSolver::solve` with `N` streamtubes. Warm starts
+ * between solves are not supported, with `continuation` each streamtube
+ * continues from its neighbour within the solve. `lockstep` and `parallel`
+ * have no effect.
+ *
+ * The general `VAWTSolver` handles any other number of streamtubes.
+ *
+ * @tparam N - number of streamtubes, even
+ */
+template <uint N> class FixedVAWTSolver {
+    static_assert(N > 0 && N % 2 == 0,
+                  "the number of streamtubes must be even");
+
+  private:
+    struct Trig {
+        std::array<double, N> cos_theta;
+        std::array<double, N> sin_theta;
+        std::array<double, N> width;
+    };
+
+    VAWTSolver solver;
+    VAWTCase case_{};
+
+    /**
+     * @brief the trigonometry of `THETA`, computed on first use
+     *
+     * @return const Trig&
+     */
+    static const Trig& trig() {
+        static const Trig trig = [] {
+            const double pi = boost::math::double_constants::pi;
+            Trig trig;
+            for (size_t i = 0; i < N; i++) {
+                trig.cos_theta[i] = std::cos(THETA[i]);
+                trig.sin_theta[i] = std::sin(THETA[i]);
+                trig.width[i] = pi * std::abs(trig.sin_theta[i]);
+            }
+            return trig;
+        }();
+        return trig;
+    }
+
+    StreamTube tube(size_t i, double beta, double a_0) const {
+        const Trig& trig = FixedVAWTSolver::trig();
+        return StreamTube(THETA[i], trig.cos_theta[i], trig.sin_theta[i],
+                          trig.width[i], beta, a_0);
+    }
+
+  public:
+    /**
+     * @brief location of each streamtube in radians
+     */
+    static constexpr std::array<double, N> THETA = fixed_theta<N>();
+
+    /**
+     * @brief Construct a new FixedVAWTSolver with the settings of `solver`
+     *
+     * @param solver - its number of streamtubes is replaced by `N`
+     */
+    explicit FixedVAWTSolver(VAWTSolver solver) : solver(std::move(solver)) {
+        this->solver.n_streamtubes(N);
+    }
+
+    /**
+     * @brief the settings used for the next solves, changing the number of
+     * streamtubes has no effect
+     *
+     * @return VAWTSolver&
+     */
+    VAWTSolver& settings() { return this->solver; }
+
+    /**
+     * @brief solve for the pitch schedule `beta`
+     *
+     * @tparam Pitch - see `VAWTSolver::solve`
+     * @param beta - pitch angle as a function of theta
+     * @return FixedSolution<N>
+     */
+    template <PitchSchedule Pitch> FixedSolution<N> solve(const Pitch& beta) {
+        FixedSolution<N> solution;
+        this->solve_into(beta, solution);
+        return solution;
+    }
+    FixedSolution<N> solve(double beta) {
+        return this->solve(ConstantPitch(beta));
+    }
+
+    /**
+     * @brief solve into an existing solution, overwriting it
+     *
+     * @tparam Pitch - see `VAWTSolver::solve`
+     * @param beta - pitch angle as a function of theta
+     * @param solution - output
+     */
+    template <PitchSchedule Pitch>
+    void solve_into(const Pitch& beta, FixedSolution<N>& solution) {
+        const VAWTSolver& s = this->solver;
+        this->solver.prepare_case(this->case_);
+        pitch_angles(beta, std::span<const double>(THETA),
+                     std::span<double>(solution._beta));
+        std::array<TubeResult, N>& results = solution._results;
+        for (size_t i = 0; i < N / 2; i++) {
+            size_t i_down = N - 1 - i;
+            double guess_up = NAN;
+            double guess_down = NAN;
+            if (s._continuation && i > 0) {
+                // continue from the neighbouring streamtubes
+                const TubeResult& left = results[i - 1];
+                const TubeResult& right = results[i_down + 1];
+                guess_up = left.bracketed ? left.a : NAN;
+                guess_down = right.bracketed ? right.a : NAN;
+            }
+            results[i] = this->tube(i, solution._beta[i], 0.0)
+                             .solve_a(this->case_, s._root_finder, s._epsilon,
+                                      s._residual, guess_up);
+            results[i_down] =
+                this->tube(i_down, solution._beta[i_down], results[i].a)
+                    .solve_a(this->case_, s._root_finder, s._epsilon,
+                             s._residual, guess_down);
+        }
+
+        VAWTCase& case_ = solution.case_;
+        case_.re = this->case_.re;
+        case_.tsr = this->case_.tsr;
+        case_.solidity = this->case_.solidity;
+        if (case_.aerofoil != this->case_.aerofoil) {
+            case_.aerofoil = this->case_.aerofoil;
+        }
+        // the solution may outlive the view
+        case_.polar = nullptr;
+    }
+};
+
+} // namespace vawt
@@ -0,0 +1,234 @@
+#include "operating_point.hpp"
+#include "private_stuff.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace std;
+
+namespace vawt {
+
+/**
+ * @brief golden section ratio of Brent's minimization
+ */
+const double C_GOLD = 0.3819660112501051;
+
+/**
+ * @brief the solves of one search, each warm started from the one before
+ */
+class TsrSearch {
+  private:
+    VAWTSolver solver;
+    const function<double(double)>& beta;
+    VAWTSolver::Workspace workspace;
+    vector<pair<double, VAWTSolution>> solved;
+
+  public:
+    TsrSearch(VAWTSolver solver, const function<double(double)>& beta)
+        : solver(std::move(solver)), beta(beta) {}
+
+    /**
+     * @brief solve at `tsr`
+     *
+     * @param tsr
+     * @return VAWTSolution& - valid until the next solve
+     */
+    VAWTSolution& solve(double tsr) {
+        this->solver.tsr(tsr);
+        if (!this->solved.empty()) {
+            this->solver.warm_start(this->solved.back().second);
+        }
+        this->solved.emplace_back(tsr, VAWTSolution());
+        VAWTSolution& solution = this->solved.back().second;
+        this->solver.solve_into(this->beta, this->workspace, solution);
+        return solution;
+    }
+
+    /**
+     * @brief number of solves so far
+     *
+     * @return uint
+     */
+    uint solves() const { return this->solved.size(); }
+
+    /**
+     * @brief the result at `tsr`, which must have been solved or be `NaN`
+     *
+     * @param tsr
+     * @param converged
+     * @return TsrResult
+     */
+    TsrResult result(double tsr, bool converged) {
+        TsrResult result{tsr, VAWTSolution(), this->solves(), converged};
+        for (auto& [x, solution] : this->solved) {
+            if (x == tsr) {
+                result.solution = std::move(solution);
+                break;
+            }
+        }
+        return result;
+    }
+};
+
+vector<double> OperatingPointSolver::scan_tsr() const {
+    size_t n = this->_scan_points;
+    if (n < 3 || this->_max_solves < n || !(this->tsr_min < this->tsr_max)) {
+        throw "an operating point search needs at least 3 scan points within "
+              "its solves on a non empty range";
+    }
+    vector<double> x(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = this->tsr_min +
+               (this->tsr_max - this->tsr_min) * (double)i / (double)(n - 1);
+    }
+    return x;
+}
+
+TsrResult
+OperatingPointSolver::optimal_tsr(VAWTSolver solver,
+                                  const function<double(double)>& beta) const {
+    TsrSearch search(std::move(solver), beta);
+    // Brent's method minimizes, so the power is negated
+    vector<double> x = this->scan_tsr();
+    size_t n = x.size();
+    vector<double> f(n);
+    for (size_t i = 0; i < n; i++) {
+        f[i] = -search.solve(x[i]).c_power();
+    }
+    size_t i = min_element(f.begin(), f.end()) - f.begin();
+
+    // the maximum lies in [a, b], `best` is the best point so far, w the
+    // second best and v the previous value of w
+    double a = x[(i > 0) ? i - 1 : 0];
+    double b = x[min(i + 1, n - 1)];
+    double v = x[i], w = v;
+    double fx = f[i], fw = fx, fv = fx;
+    double best = x[i];
+    double d = 0.0, e = 0.0;
+    double tol_1 = 0.5 * this->_tolerance;
+    double tol_2 = this->_tolerance;
+    while (true) {
+        double xm = 0.5 * (a + b);
+        if (abs(best - xm) <= tol_2 - 0.5 * (b - a)) {
+            return search.result(best, true);
+        }
+        if (search.solves() >= this->_max_solves) {
+            return search.result(best, false);
+        }
+        bool golden = true;
+        if (abs(e) > tol_1) {
+            // parabola through best, w and v
+            double r = (best - w) * (fx - fv);
+            double q = (best - v) * (fx - fw);
+            double p = (best - v) * q - (best - w) * r;
+            q = 2.0 * (q - r);
+            if (q > 0.0) {
+                p = -p;
+            }
+            q = abs(q);
+            double e_prev = e;
+            e = d;
+            if (abs(p) < abs(0.5 * q * e_prev) && p > q * (a - best) &&
+                p < q * (b - best)) {
+                d = p / q;
+                double u = best + d;
+                if (u - a < tol_2 || b - u < tol_2) {
+                    d = copysign(tol_1, xm - best);
+                }
+                golden = false;
+            }
+        }
+        if (golden) {
+            e = (best >= xm) ? a - best : b - best;
+            d = C_GOLD * e;
+        }
+        double u = (abs(d) >= tol_1) ? best + d : best + copysign(tol_1, d);
+        double fu = -search.solve(u).c_power();
+        if (fu <= fx) {
+            if (u >= best) {
+                a = best;
+            } else {
+                b = best;
+            }
+            v = w;
+            fv = fw;
+            w = best;
+            fw = fx;
+            best = u;
+            fx = fu;
+        } else {
+            if (u < best) {
+                a = u;
+            } else {
+                b = u;
+            }
+            if (fu <= fw || w == best) {
+                v = w;
+                fv = fw;
+                w = u;
+                fw = fu;
+            } else if (fu <= fv || v == best || v == w) {
+                v = u;
+                fv = fu;
+            }
+        }
+    }
+}
+
+TsrResult OperatingPointSolver::tsr_for_torque(
+    VAWTSolver solver, const function<double(double)>& load,
+    const function<double(double)>& beta) const {
+    TsrSearch search(std::move(solver), beta);
+    auto excess = [&](double tsr) {
+        return search.solve(tsr).c_torque() - load(tsr);
+    };
+    vector<double> x = this->scan_tsr();
+    size_t n = x.size();
+    vector<double> g(n);
+    for (size_t i = 0; i < n; i++) {
+        g[i] = excess(x[i]);
+    }
+    // the highest crossing where the excess torque turns negative
+    size_t k = n - 1;
+    while (k > 0 && !(g[k - 1] > 0.0 && g[k] <= 0.0)) {
+        k--;
+    }
+    if (k == 0) {
+        return search.result(NAN, false);
+    }
+    if (g[k] == 0.0) {
+        return search.result(x[k], true);
+    }
+    TubeResult root = brent(excess, x[k - 1], x[k], g[k - 1], g[k],
+                            this->_tolerance, 0.0,
+                            this->_max_solves - search.solves());
+    return search.result(root.a, root.converged);
+}
+
+vector<TsrResult>
+OperatingPointSolver::optimal_tsr(const vector<TsrQuery>& queries) const {
+    vector<TsrResult> results(queries.size());
+    this->_pool->parallel_for(queries.size(), [&](size_t i) {
+        const TsrQuery& query = queries[i];
+        VAWTSolver solver = this->solver;
+        solver.re(query.re).solidity(query.solidity);
+        results[i] = this->optimal_tsr(std::move(solver), query.beta);
+    });
+    return results;
+}
+
+vector<TsrResult>
+OperatingPointSolver::tsr_for_torque(const vector<TsrQuery>& queries) const {
+    vector<TsrResult> results(queries.size());
+    this->_pool->parallel_for(queries.size(), [&](size_t i) {
+        const TsrQuery& query = queries[i];
+        VAWTSolver solver = this->solver;
+        solver.re(query.re).solidity(query.solidity);
+        results[i] =
+            this->tsr_for_torque(std::move(solver), query.load, query.beta);
+    });
+    return results;
+}
+
+} // namespace vawt
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include "vawt.hpp"
+#include <functional>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief one query of an `OperatingPointSolver`
+ */
+struct TsrQuery {
+    /**
+     * @brief Reynolds number of the turbine
+     */
+    double re;
+
+    /**
+     * @brief Turbine solidity
+     */
+    double solidity;
+
+    /**
+     * @brief pitch angle as a function of theta
+     */
+    std::function<double(double)> beta;
+
+    /**
+     * @brief torque coefficient of the load as a function of tsr, only used
+     * by `OperatingPointSolver::tsr_for_torque`
+     */
+    std::function<double(double)> load;
+};
+
+/**
+ * @brief the operating point found by an `OperatingPointSolver`
+ */
+struct TsrResult {
+    /**
+     * @brief Tipspeed ratio of the operating point, `NaN` when none was
+     * found
+     */
+    double tsr;
+
+    /**
+     * @brief the solution at `tsr`
+     */
+    VAWTSolution solution;
+
+    /**
+     * @brief number of solves spent on the search
+     */
+    uint solves;
+
+    /**
+     * @brief false when the solve limit was reached before the tolerance or
+     * no operating point was found
+     */
+    bool converged;
+};
+
+/**
+ * @brief find operating points of a turbine: the tip speed ratio of maximum
+ * power and the one at which the turbine torque matches a load
+ *
+ * A search first solves a few tip speed ratios spread evenly over the range
+ * to bracket the operating point, then narrows the bracket with Brent's
+ * method: golden section and parabolic steps to maximize the power, inverse
+ * quadratic interpolation to match the torque. Each solve is warm started
+ * (see `VAWTSolver::warm_start`) from the previous solve of the search.
+ *
+ * Many queries are searched in parallel, one task per query. Each search is
+ * serial and independent of the others, the results do not depend on the
+ * number of threads.
+ */
+class OperatingPointSolver {
+  private:
+    VAWTSolver solver;
+    double tsr_min = 1.0;
+    double tsr_max = 6.0;
+    double _tolerance = 1e-3;
+    uint _scan_points = 6;
+    uint _max_solves = 50;
+    ThreadPool* _pool = &ThreadPool::shared();
+
+    /**
+     * @brief the evenly spread tip speed ratios that bracket an operating
+     * point, throws on invalid settings
+     *
+     * @return std::vector<double>
+     */
+    std::vector<double> scan_tsr() const;
+
+    TsrResult optimal_tsr(VAWTSolver solver,
+                          const std::function<double(double)>& beta) const;
+    TsrResult tsr_for_torque(VAWTSolver solver,
+                             const std::function<double(double)>& load,
+                             const std::function<double(double)>& beta) const;
+
+  public:
+    /**
+     * @brief Construct a new OperatingPointSolver
+     *
+     * @param solver - aerofoil and solve settings, its tsr is replaced by
+     * the search
+     */
+    explicit OperatingPointSolver(VAWTSolver solver)
+        : solver(std::move(solver)) {}
+
+    /**
+     * @brief the range of tip speed ratios to search, `[1, 6]` by default
+     *
+     * @param tsr_min
+     * @param tsr_max
+     * @return OperatingPointSolver&
+     */
+    OperatingPointSolver& tsr_range(double tsr_min, double tsr_max) {
+        this->tsr_min = tsr_min;
+        this->tsr_max = tsr_max;
+        return *this;
+    }
+
+    /**
+     * @brief stop once the tip speed ratio is located within this, 1e-3 by
+     * default
+     *
+     * @param tolerance
+     * @return OperatingPointSolver&
+     */
+    OperatingPointSolver& tolerance(double tolerance) {
+        this->_tolerance = tolerance;
+        return *this;
+    }
+
+    /**
+     * @brief number of evenly spread tip speed ratios solved to bracket the
+     * operating point, at least 3, 6 by default
+     *
+     * @param n
+     * @return OperatingPointSolver&
+     */
+    OperatingPointSolver& scan_points(uint n) {
+        this->_scan_points = n;
+        return *this;
+    }
+
+    /**
+     * @brief stop each search after this many solves, 50 by default
+     *
+     * @param n
+     * @return OperatingPointSolver&
+     */
+    OperatingPointSolver& max_solves(uint n) {
+        this->_max_solves = n;
+        return *this;
+    }
+
+    /**
+     * @brief run the queries on `pool` instead of `ThreadPool::shared()`
+     *
+     * The pool must outlive the solver.
+     *
+     * @param pool
+     * @return OperatingPointSolver&
+     */
+    OperatingPointSolver& pool(ThreadPool& pool) {
+        this->_pool = &pool;
+        return *this;
+    }
+
+    /**
+     * @brief the tip speed ratio of maximum `VAWTSolution::c_power`
+     *
+     * The maximum is searched around the best of the scanned tip speed
+     * ratios, so it is the global one as long as the scan resolves the peak.
+     *
+     * @param beta - pitch angle as a function of theta
+     * @return TsrResult
+     */
+    TsrResult optimal_tsr(const std::function<double(double)>& beta) const {
+        return this->optimal_tsr(this->solver, beta);
+    }
+
+    /**
+     * @brief the tip speed ratio at which `VAWTSolution::c_torque` equals
+     * the torque coefficient of `load`
+     *
+     * Of several such tip speed ratios the highest is taken at which the
+     * turbine torque drops below the load with increasing tsr, the stable
+     * operating point of a loaded turbine.
+     *
+     * @param load - torque coefficient of the load as a function of tsr
+     * @param beta - pitch angle as a function of theta
+     * @return TsrResult
+     */
+    TsrResult
+    tsr_for_torque(const std::function<double(double)>& load,
+                   const std::function<double(double)>& beta) const {
+        return this->tsr_for_torque(this->solver, load, beta);
+    }
+
+    /**
+     * @brief `optimal_tsr` of each query, in parallel
+     *
+     * @param queries
+     * @return std::vector<TsrResult> - in the order of `queries`
+     */
+    std::vector<TsrResult>
+    optimal_tsr(const std::vector<TsrQuery>& queries) const;
+
+    /**
+     * @brief `tsr_for_torque` of each query, in parallel
+     *
+     * @param queries
+     * @return std::vector<TsrResult> - in the order of `queries`
+     */
+    std::vector<TsrResult>
+    tsr_for_torque(const std::vector<TsrQuery>& queries) const;
+};
+
+} // namespace vawt
@@ -0,0 +1,310 @@
+#include "performance_map.hpp"
+#include "polar_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+namespace vawt {
+
+const char MAP_MAGIC[8] = {'V', 'A', 'W', 'T', 'P', 'M', 'A', 'P'};
+const uint32_t MAP_VERSION = 1;
+
+/**
+ * @brief hours of an average year
+ */
+const double HOURS_PER_YEAR = 8766.0;
+
+/**
+ * @brief width of the wind speed bins of a Weibull distribution in m/s
+ */
+const double WEIBULL_BIN = 0.05;
+
+/**
+ * @brief the header at the start of each map file
+ *
+ * The `(c_power, c_torque)` pairs of all slices follow directly after the
+ * header. Its size is a multiple of 8, so they are correctly aligned in the
+ * mapping.
+ */
+struct MapHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t n_tsr;
+    uint64_t n_re;
+    uint64_t n_amplitude;
+    double tsr_0;
+    double d_tsr;
+    double log_re_0;
+    double d_log_re;
+    double amplitude_0;
+    double d_amplitude;
+};
+
+static_assert(sizeof(MapHeader) % sizeof(double) == 0);
+
+PerformanceMap::PerformanceMap(vector<PolarTable> slices, double amplitude_0,
+                               double d_amplitude)
+    : slices(std::move(slices)), amplitude_0(amplitude_0),
+      d_amplitude(d_amplitude) {
+    if (this->slices.empty()) {
+        throw "a performance map needs at least one slice";
+    }
+}
+
+pair<size_t, double> PerformanceMap::slice_weight(double amplitude) const {
+    size_t n = this->slices.size();
+    if (n == 1) {
+        return {0, 0.0};
+    }
+    double x = clamp((amplitude - this->amplitude_0) / this->d_amplitude, 0.0,
+                     (double)(n - 1));
+    size_t k = min((size_t)x, n - 2);
+    return {k, x - (double)k};
+}
+
+pair<double, double> PerformanceMap::operator()(double tsr, double re,
+                                                double amplitude) const {
+    auto [k, t] = this->slice_weight(amplitude);
+    auto [c_power, c_torque] = this->slices[k](tsr, re);
+    if (t == 0.0) {
+        return {c_power, c_torque};
+    }
+    auto [c_power_1, c_torque_1] = this->slices[k + 1](tsr, re);
+    return {(1.0 - t) * c_power + t * c_power_1,
+            (1.0 - t) * c_torque + t * c_torque_1};
+}
+
+void PerformanceMap::eval(span<const double> tsr, span<const double> re,
+                          double amplitude, span<double> c_power,
+                          span<double> c_torque) const {
+    size_t n = tsr.size();
+    if (re.size() != n || c_power.size() != n || c_torque.size() != n) {
+        throw "PerformanceMap: all spans must have the same size";
+    }
+    auto [k, t] = this->slice_weight(amplitude);
+    this->slices[k].eval(tsr.data(), re.data(), c_power.data(),
+                         c_torque.data(), n, false);
+    if (t == 0.0) {
+        return;
+    }
+    vector<double> c_power_1(n), c_torque_1(n);
+    this->slices[k + 1].eval(tsr.data(), re.data(), c_power_1.data(),
+                             c_torque_1.data(), n, false);
+    for (size_t i = 0; i < n; i++) {
+        c_power[i] = (1.0 - t) * c_power[i] + t * c_power_1[i];
+        c_torque[i] = (1.0 - t) * c_torque[i] + t * c_torque_1[i];
+    }
+}
+
+double PerformanceMap::annual_energy(const YieldSettings& settings,
+                                     span<const double> speed,
+                                     span<const double> hours) const {
+    size_t n = speed.size();
+    if (hours.size() != n) {
+        throw "PerformanceMap: all spans must have the same size";
+    }
+    vector<double> tsr(n, settings.tsr), re(n), c_power(n), c_torque(n);
+    for (size_t i = 0; i < n; i++) {
+        re[i] = settings.re_per_speed * speed[i];
+    }
+    this->eval(tsr, re, settings.amplitude, c_power, c_torque);
+
+    double energy = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        if (speed[i] < settings.cut_in || speed[i] > settings.cut_out) {
+            continue;
+        }
+        double power = 0.5 * settings.density * settings.area *
+                       pow(speed[i], 3) * c_power[i];
+        // a turbine that would need driving is stopped
+        energy += clamp(power, 0.0, settings.rated_power) * hours[i];
+    }
+    return energy / 1000.0;
+}
+
+double PerformanceMap::annual_energy(const YieldSettings& settings, double k,
+                                     double c) const {
+    if (!(settings.cut_in < settings.cut_out) || isinf(settings.cut_out)) {
+        throw "the Weibull yield needs a finite wind speed range";
+    }
+    auto cdf = [&](double speed) { return 1.0 - exp(-pow(speed / c, k)); };
+    size_t n = (size_t)ceil((settings.cut_out - settings.cut_in) / WEIBULL_BIN);
+    vector<double> speed(n), hours(n);
+    for (size_t i = 0; i < n; i++) {
+        double lo = settings.cut_in + (double)i * WEIBULL_BIN;
+        double hi = min(lo + WEIBULL_BIN, settings.cut_out);
+        speed[i] = 0.5 * (lo + hi);
+        hours[i] = (cdf(hi) - cdf(lo)) * HOURS_PER_YEAR;
+    }
+    return this->annual_energy(settings, speed, hours);
+}
+
+void PerformanceMap::save(string_view file) const {
+    const PolarTable& first = this->slices.front();
+    MapHeader header;
+    memcpy(header.magic, MAP_MAGIC, sizeof(header.magic));
+    header.version = MAP_VERSION;
+    header.flags = 0;
+    header.n_tsr = first.n_alpha();
+    header.n_re = first.n_re();
+    header.n_amplitude = this->slices.size();
+    header.tsr_0 = first.alpha_0();
+    header.d_tsr = first.d_alpha();
+    header.log_re_0 = first.log_re_0();
+    header.d_log_re = first.d_log_re();
+    header.amplitude_0 = this->amplitude_0;
+    header.d_amplitude = this->d_amplitude;
+
+    write_file(
+        file,
+        [&](ostream& out) {
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            for (const PolarTable& slice : this->slices) {
+                out.write(reinterpret_cast<const char*>(slice.data()),
+                          slice.size_bytes());
+            }
+        },
+        "could not write performance map file");
+}
+
+PerformanceMap PerformanceMap::load(string_view file) {
+    size_t len = 0;
+    shared_ptr<const void> mapping = map_file(file, len);
+    if (!mapping || len < sizeof(MapHeader)) {
+        throw "could not read performance map file";
+    }
+    auto header = static_cast<const MapHeader*>(mapping.get());
+    if (memcmp(header->magic, MAP_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != MAP_VERSION || header->n_tsr < 2 ||
+        header->n_re < 2 || header->n_amplitude < 1 ||
+        !valid_grid(len, sizeof(MapHeader),
+                    {header->n_tsr, header->n_re, header->n_amplitude},
+                    {header->d_tsr, header->d_log_re, header->d_amplitude})) {
+        throw "not a valid performance map file";
+    }
+    size_t slice_len = 2 * header->n_tsr * header->n_re;
+    auto values = reinterpret_cast<const double*>(header + 1);
+    vector<PolarTable> slices;
+    for (size_t k = 0; k < header->n_amplitude; k++) {
+        slices.emplace_back(header->tsr_0, header->d_tsr, header->log_re_0,
+                            header->d_log_re, header->n_tsr, header->n_re,
+                            mapping, values + k * slice_len);
+    }
+    return PerformanceMap(std::move(slices), header->amplitude_0,
+                          header->d_amplitude);
+}
+
+function<double(double)> PerformanceMapBuilder::pitch(double amplitude) const {
+    return [shape = this->shape, amplitude](double theta) {
+        return amplitude * shape(theta);
+    };
+}
+
+PerformanceMap PerformanceMapBuilder::build() const {
+    if (this->n_tsr < 2 || this->n_re < 2 || this->n_amplitude < 1 ||
+        !(this->tsr_min < this->tsr_max) || !(this->re_min < this->re_max) ||
+        (this->n_amplitude > 1 &&
+         !(this->amplitude_min < this->amplitude_max))) {
+        throw "a performance map needs at least 2 points on non empty tsr "
+              "and re ranges";
+    }
+    double d_tsr = (this->tsr_max - this->tsr_min) / (double)(this->n_tsr - 1);
+    double log_re_0 = log(this->re_min);
+    double d_log_re =
+        (log(this->re_max) - log_re_0) / (double)(this->n_re - 1);
+    double d_amplitude =
+        (this->n_amplitude > 1)
+            ? (this->amplitude_max - this->amplitude_min) /
+                  (double)(this->n_amplitude - 1)
+            : 1.0;
+
+    size_t slice_len = 2 * this->n_tsr * this->n_re;
+    vector<vector<double>> data(this->n_amplitude, vector<double>(slice_len));
+    this->_pool->parallel_for(
+        this->n_amplitude * this->n_re * this->n_tsr, [&](size_t index) {
+            size_t i = index % this->n_tsr;
+            size_t j = (index / this->n_tsr) % this->n_re;
+            size_t k = index / (this->n_tsr * this->n_re);
+            VAWTSolution solution;
+            this->solver.solve_at(
+                this->tsr_min + (double)i * d_tsr,
+                exp(log_re_0 + (double)j * d_log_re),
+                this->pitch(this->amplitude_min + (double)k * d_amplitude),
+                solution);
+            double* p = &data[k][2 * (j * this->n_tsr + i)];
+            p[0] = solution.c_power();
+            p[1] = solution.c_torque();
+        });
+
+    vector<PolarTable> slices;
+    for (vector<double>& values : data) {
+        slices.emplace_back(this->tsr_min, d_tsr, log_re_0, d_log_re,
+                            this->n_tsr, this->n_re, std::move(values));
+    }
+    return PerformanceMap(std::move(slices), this->amplitude_min,
+                          d_amplitude);
+}
+
+MapError PerformanceMapBuilder::error_report(const PerformanceMap& map,
+                                             size_t max_samples) const {
+    size_t n_t = this->n_tsr - 1;
+    size_t n_r = this->n_re - 1;
+    size_t n_a = max(this->n_amplitude - 1, (size_t)1);
+    size_t n_cells = n_t * n_r * n_a;
+    size_t n = min(n_cells, max_samples);
+    double d_tsr = (this->tsr_max - this->tsr_min) / (double)n_t;
+    double log_re_0 = log(this->re_min);
+    double d_log_re = (log(this->re_max) - log_re_0) / (double)n_r;
+    double d_amplitude =
+        (this->amplitude_max - this->amplitude_min) / (double)n_a;
+
+    // with fewer samples than cells, a low discrepancy sequence picks the
+    // cells, so all axes are covered evenly
+    auto cell = [&](size_t s) -> array<size_t, 3> {
+        if (n == n_cells) {
+            return {s % n_t, (s / n_t) % n_r, s / (n_t * n_r)};
+        }
+        auto axis = [&](double alpha, size_t n_axis) {
+            double x = fmod(0.5 + (double)s * alpha, 1.0);
+            return min((size_t)(x * (double)n_axis), n_axis - 1);
+        };
+        return {axis(0.8191725133961645, n_t), axis(0.6710436067037893, n_r),
+                axis(0.5497004779019703, n_a)};
+    };
+    vector<double> error_power(n), error_torque(n);
+    this->_pool->parallel_for(n, [&](size_t s) {
+        auto [i, j, k] = cell(s);
+        double tsr = this->tsr_min + ((double)i + 0.5) * d_tsr;
+        double re = exp(log_re_0 + ((double)j + 0.5) * d_log_re);
+        double amplitude =
+            (this->n_amplitude > 1)
+                ? this->amplitude_min + ((double)k + 0.5) * d_amplitude
+                : this->amplitude_min;
+        VAWTSolution solution;
+        this->solver.solve_at(tsr, re, this->pitch(amplitude), solution);
+        auto [c_power, c_torque] = map(tsr, re, amplitude);
+        error_torque[s] = abs(c_torque - solution.c_torque());
+        error_power[s] = abs(c_power - solution.c_power());
+    });
+
+    MapError report{n, 0.0, 0.0, 0.0, 0.0};
+    for (size_t s = 0; s < n; s++) {
+        report.max_c_power = max(report.max_c_power, error_power[s]);
+        report.max_c_torque = max(report.max_c_torque, error_torque[s]);
+        report.rms_c_power += error_power[s] * error_power[s];
+        report.rms_c_torque += error_torque[s] * error_torque[s];
+    }
+    report.rms_c_power = sqrt(report.rms_c_power / (double)max(n, (size_t)1));
+    report.rms_c_torque =
+        sqrt(report.rms_c_torque / (double)max(n, (size_t)1));
+    return report;
+}
+
+} // namespace vawt
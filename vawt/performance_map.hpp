@@ -0,0 +1,370 @@
+#pragma once
+
+#include "polar_table.hpp"
+#include "thread_pool.hpp"
+#include "vawt.hpp"
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief a turbine at a site, for the energy yield of a `PerformanceMap`
+ */
+struct YieldSettings {
+    /**
+     * @brief swept area of the rotor in m^2
+     */
+    double area;
+
+    /**
+     * @brief reynolds number of the turbine at a wind speed of 1 m/s, the
+     * reynolds number grows linearly with the wind speed
+     */
+    double re_per_speed;
+
+    /**
+     * @brief the tip speed ratio the turbine is operated at
+     */
+    double tsr;
+
+    /**
+     * @brief pitch amplitude in radians
+     */
+    double amplitude = 0.0;
+
+    /**
+     * @brief air density in kg/m^3
+     */
+    double density = 1.225;
+
+    /**
+     * @brief no power below this wind speed in m/s
+     */
+    double cut_in = 0.0;
+
+    /**
+     * @brief no power above this wind speed in m/s
+     */
+    double cut_out = 25.0;
+
+    /**
+     * @brief the power is capped at this in W
+     */
+    double rated_power = std::numeric_limits<double>::infinity();
+};
+
+/**
+ * @brief the interpolation error of a `PerformanceMap` against direct solves,
+ * see `PerformanceMapBuilder::error_report`
+ */
+struct MapError {
+    /**
+     * @brief number of direct solves compared
+     */
+    size_t samples;
+
+    /**
+     * @brief largest absolute error of the power coefficient
+     */
+    double max_c_power;
+
+    /**
+     * @brief root mean square error of the power coefficient
+     */
+    double rms_c_power;
+
+    /**
+     * @brief largest absolute error of the torque coefficient
+     */
+    double max_c_torque;
+
+    /**
+     * @brief root mean square error of the torque coefficient
+     */
+    double rms_c_torque;
+};
+
+/**
+ * @brief power and torque coefficient of a turbine tabulated over tip speed
+ * ratio, reynolds number and pitch amplitude
+ *
+ * Each pitch amplitude is a `PolarTable` slice over a uniform tsr and a
+ * uniform log(re) grid, holding `(c_power, c_torque)` pairs in place of
+ * `(cl, cd)`. A lookup is index arithmetic and a linear blend of at most 8
+ * grid points, independent of the size of the map. Outside of the grid the
+ * values are extrapolated as constants.
+ *
+ * Maps are built by a `PerformanceMapBuilder`, and can be saved to and
+ * memory mapped from a binary file.
+ */
+class PerformanceMap {
+  private:
+    std::vector<PolarTable> slices;
+    double amplitude_0;
+    double d_amplitude;
+
+    /**
+     * @brief the two slices around `amplitude` and the weight of the second
+     *
+     * @param amplitude
+     * @return std::pair<size_t, double>
+     */
+    std::pair<size_t, double> slice_weight(double amplitude) const;
+
+  public:
+    /**
+     * @brief Construct a new PerformanceMap
+     *
+     * @param slices - one table per pitch amplitude, all on the same grid
+     * @param amplitude_0 - pitch amplitude of the first slice in radians
+     * @param d_amplitude - pitch amplitude spacing of the slices
+     */
+    PerformanceMap(std::vector<PolarTable> slices, double amplitude_0,
+                   double d_amplitude);
+
+    /**
+     * @brief power and torque coefficient
+     *
+     * @param tsr
+     * @param re
+     * @param amplitude - pitch amplitude in radians
+     * @return std::pair<double, double> - `(c_power, c_torque)`
+     */
+    std::pair<double, double> operator()(double tsr, double re,
+                                         double amplitude = 0.0) const;
+
+    /**
+     * @brief power coefficient, see `operator()`
+     *
+     * @param tsr
+     * @param re
+     * @param amplitude - pitch amplitude in radians
+     * @return double
+     */
+    double c_power(double tsr, double re, double amplitude = 0.0) const {
+        return (*this)(tsr, re, amplitude).first;
+    }
+
+    /**
+     * @brief torque coefficient, see `operator()`
+     *
+     * @param tsr
+     * @param re
+     * @param amplitude - pitch amplitude in radians
+     * @return double
+     */
+    double c_torque(double tsr, double re, double amplitude = 0.0) const {
+        return (*this)(tsr, re, amplitude).second;
+    }
+
+    /**
+     * @brief power and torque coefficients for many points at once, with the
+     * batched lookup of `PolarTable::eval`
+     *
+     * @param tsr
+     * @param re
+     * @param amplitude - pitch amplitude of all points in radians
+     * @param c_power - output
+     * @param c_torque - output
+     */
+    void eval(std::span<const double> tsr, std::span<const double> re,
+              double amplitude, std::span<double> c_power,
+              std::span<double> c_torque) const;
+
+    /**
+     * @brief annual energy production in kWh for a histogram of wind speeds
+     *
+     * The power coefficient of all wind speeds is looked up in one batch.
+     *
+     * @param settings - the turbine and how it is operated
+     * @param speed - wind speed of each bin in m/s
+     * @param hours - hours per year of each bin
+     * @return double
+     */
+    double annual_energy(const YieldSettings& settings,
+                         std::span<const double> speed,
+                         std::span<const double> hours) const;
+
+    /**
+     * @brief annual energy production in kWh for a Weibull distribution of
+     * wind speeds
+     *
+     * The distribution is split into bins of 0.05 m/s between cut in and cut
+     * out, each weighted by its exact probability.
+     *
+     * @param settings - the turbine and how it is operated
+     * @param k - shape parameter
+     * @param c - scale parameter in m/s
+     * @return double
+     */
+    double annual_energy(const YieldSettings& settings, double k,
+                         double c) const;
+
+    /**
+     * @brief write the map to a versioned binary file
+     *
+     * The file is a fixed size header followed by the coefficients of all
+     * slices in native byte order. It is written to a temporary file first
+     * and then renamed, concurrent readers never see a partial file.
+     *
+     * @param file
+     */
+    void save(std::string_view file) const;
+
+    /**
+     * @brief memory map a file written by `save`
+     *
+     * The slices reference the mapping directly, nothing is copied.
+     *
+     * @param file
+     * @return PerformanceMap
+     */
+    static PerformanceMap load(std::string_view file);
+
+    /**
+     * @brief the tables of each pitch amplitude
+     *
+     * @return const std::vector<PolarTable>&
+     */
+    const std::vector<PolarTable>& tables() const { return this->slices; }
+};
+
+/**
+ * @brief build a `PerformanceMap` with a `VAWTSolver`
+ *
+ * The grid points are solved in parallel on a thread pool, each by a copy
+ * of the solver passed to the constructor. The pitch schedule of an
+ * amplitude `A` is `A * shape(theta)`.
+ */
+class PerformanceMapBuilder {
+  private:
+    VAWTSolver solver;
+    std::function<double(double)> shape = [](double theta) {
+        return std::sin(theta);
+    };
+    double tsr_min = 1.0, tsr_max = 5.0;
+    size_t n_tsr = 41;
+    double re_min = 20'000.0, re_max = 160'000.0;
+    size_t n_re = 8;
+    double amplitude_min = 0.0, amplitude_max = 0.0;
+    size_t n_amplitude = 1;
+    ThreadPool* _pool = &ThreadPool::shared();
+
+    /**
+     * @brief pitch schedule of `amplitude`
+     *
+     * @param amplitude
+     * @return std::function<double(double)>
+     */
+    std::function<double(double)> pitch(double amplitude) const;
+
+  public:
+    /**
+     * @brief Construct a new PerformanceMapBuilder
+     *
+     * @param solver - aerofoil and solve settings, its tsr and re are
+     * replaced by the grid
+     */
+    explicit PerformanceMapBuilder(VAWTSolver solver)
+        : solver(std::move(solver)) {}
+
+    /**
+     * @brief uniform tsr grid, 41 points on `[1, 5]` by default
+     *
+     * @param min
+     * @param max
+     * @param n - at least 2
+     * @return PerformanceMapBuilder&
+     */
+    PerformanceMapBuilder& tsr(double min, double max, size_t n) {
+        this->tsr_min = min;
+        this->tsr_max = max;
+        this->n_tsr = n;
+        return *this;
+    }
+
+    /**
+     * @brief logarithmic reynolds number grid, 8 points on `[2e4, 1.6e5]` by
+     * default
+     *
+     * @param min
+     * @param max
+     * @param n - at least 2
+     * @return PerformanceMapBuilder&
+     */
+    PerformanceMapBuilder& re(double min, double max, size_t n) {
+        this->re_min = min;
+        this->re_max = max;
+        this->n_re = n;
+        return *this;
+    }
+
+    /**
+     * @brief uniform pitch amplitude grid in radians, only 0 by default
+     *
+     * @param min
+     * @param max
+     * @param n - at least 1
+     * @return PerformanceMapBuilder&
+     */
+    PerformanceMapBuilder& pitch_amplitude(double min, double max, size_t n) {
+        this->amplitude_min = min;
+        this->amplitude_max = max;
+        this->n_amplitude = n;
+        return *this;
+    }
+
+    /**
+     * @brief pitch schedule of a unit amplitude as a function of theta,
+     * `sin(theta)` by default
+     *
+     * @param shape
+     * @return PerformanceMapBuilder&
+     */
+    PerformanceMapBuilder& pitch_shape(std::function<double(double)> shape) {
+        this->shape = std::move(shape);
+        return *this;
+    }
+
+    /**
+     * @brief run on `pool` instead of `ThreadPool::shared()`
+     *
+     * The pool must outlive the builder.
+     *
+     * @param pool
+     * @return PerformanceMapBuilder&
+     */
+    PerformanceMapBuilder& pool(ThreadPool& pool) {
+        this->_pool = &pool;
+        return *this;
+    }
+
+    /**
+     * @brief solve all grid points
+     *
+     * @return PerformanceMap
+     */
+    PerformanceMap build() const;
+
+    /**
+     * @brief compare `map` to direct solves at the centers of its grid cells
+     *
+     * Cell centers are furthest from the grid points, where the
+     * interpolation error is largest. Up to `max_samples` cells spread
+     * evenly over the map are solved in parallel.
+     *
+     * @param map - built with the settings of this builder
+     * @param max_samples
+     * @return MapError
+     */
+    MapError error_report(const PerformanceMap& map,
+                          size_t max_samples = 200) const;
+};
+
+} // namespace vawt
@@ -0,0 +1,115 @@
+#include "pitch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <boost/math/constants/constants.hpp>
+#include <cmath>
+
+using namespace std;
+
+namespace vawt {
+
+const double TWO_PI = boost::math::double_constants::two_pi;
+
+void ConstantPitch::operator()(span<const double>, span<double> beta) const {
+    fill(beta.begin(), beta.end(), this->beta);
+}
+
+FourierPitch::FourierPitch(double a_0, vector<double> a, vector<double> b)
+    : a_0(a_0), a(std::move(a)), b(std::move(b)) {
+    size_t n = max(this->a.size(), this->b.size());
+    this->a.resize(n, 0.0);
+    this->b.resize(n, 0.0);
+}
+
+double FourierPitch::operator()(double theta) const {
+    double beta;
+    (*this)(span<const double>(&theta, 1), span<double>(&beta, 1));
+    return beta;
+}
+
+void FourierPitch::operator()(span<const double> theta,
+                              span<double> beta) const {
+    // blocks on the stack keep the harmonics of a batch in registers and L1
+    const size_t BLOCK = 64;
+    array<double, BLOCK> c_1, s_1, c_k, s_k;
+    for (size_t start = 0; start < theta.size(); start += BLOCK) {
+        size_t n = min(BLOCK, theta.size() - start);
+        const double* t = theta.data() + start;
+        double* out = beta.data() + start;
+        for (size_t i = 0; i < n; i++) {
+            c_1[i] = cos(t[i]);
+            s_1[i] = sin(t[i]);
+            c_k[i] = c_1[i];
+            s_k[i] = s_1[i];
+            out[i] = this->a_0;
+        }
+        for (size_t k = 0; k < this->a.size(); k++) {
+            double a_k = this->a[k];
+            double b_k = this->b[k];
+            for (size_t i = 0; i < n; i++) {
+                out[i] += a_k * c_k[i] + b_k * s_k[i];
+                // rotate to the next harmonic
+                double c = c_k[i] * c_1[i] - s_k[i] * s_1[i];
+                s_k[i] = s_k[i] * c_1[i] + c_k[i] * s_1[i];
+                c_k[i] = c;
+            }
+        }
+    }
+}
+
+TabulatedPitch::TabulatedPitch(vector<double> theta, vector<double> beta) {
+    if (theta.size() != beta.size() || theta.empty()) {
+        throw "TabulatedPitch: theta and beta must have the same, non zero "
+              "size";
+    }
+    if (!is_sorted(theta.begin(), theta.end(), less_equal<double>()) ||
+        theta.front() < 0.0 || theta.back() >= TWO_PI) {
+        throw "TabulatedPitch: theta must be strictly increasing within "
+              "[0, 2 PI)";
+    }
+    this->theta.push_back(theta.back() - TWO_PI);
+    this->theta.insert(this->theta.end(), theta.begin(), theta.end());
+    this->theta.push_back(theta.front() + TWO_PI);
+    this->beta.push_back(beta.back());
+    this->beta.insert(this->beta.end(), beta.begin(), beta.end());
+    this->beta.push_back(beta.front());
+}
+
+size_t TabulatedPitch::locate(double theta, size_t hint) const {
+    // the first interval starts below 0 and the last ends at or above 2 PI
+    size_t last = this->theta.size() - 2;
+    size_t i = hint;
+    if (i > last || this->theta[i] > theta) {
+        i = 0;
+    }
+    while (i < last && this->theta[i + 1] <= theta) {
+        i++;
+    }
+    return i;
+}
+
+double TabulatedPitch::interpolate(size_t i, double theta) const {
+    double t = (theta - this->theta[i]) / (this->theta[i + 1] - this->theta[i]);
+    return this->beta[i] + t * (this->beta[i + 1] - this->beta[i]);
+}
+
+double TabulatedPitch::operator()(double theta) const {
+    theta -= TWO_PI * floor(theta / TWO_PI);
+    auto it = upper_bound(this->theta.begin(), this->theta.end() - 1, theta);
+    size_t i = (size_t)(it - this->theta.begin()) - 1;
+    return this->interpolate(i, theta);
+}
+
+void TabulatedPitch::operator()(span<const double> theta,
+                                span<double> beta) const {
+    // the angles of a solve are increasing, so the search walks forward
+    size_t i = 0;
+    for (size_t k = 0; k < theta.size(); k++) {
+        double t = theta[k] - TWO_PI * floor(theta[k] / TWO_PI);
+        i = this->locate(t, i);
+        beta[k] = this->interpolate(i, t);
+    }
+}
+
+} // namespace vawt
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <concepts>
+#include <span>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief a pitch schedule that evaluates many angles in one call
+ *
+ * `Fn(theta: std::span<const double>, beta: std::span<double>)` writes the
+ * pitch angle at each `theta` to `beta`.
+ */
+template <class Pitch>
+concept BatchPitch =
+    requires(const Pitch& pitch, std::span<const double> theta,
+             std::span<double> beta) { pitch(theta, beta); };
+
+/**
+ * @brief a pitch schedule: `Fn(theta: double) -> double`, both in radians
+ */
+template <class Pitch>
+concept PitchSchedule = std::invocable<const Pitch&, double>;
+
+/**
+ * @brief the pitch angle at each `theta`, in one call for a `BatchPitch`
+ *
+ * @param pitch
+ * @param theta
+ * @param beta - output
+ */
+template <PitchSchedule Pitch>
+void pitch_angles(const Pitch& pitch, std::span<const double> theta,
+                  std::span<double> beta) {
+    if constexpr (BatchPitch<Pitch>) {
+        pitch(theta, beta);
+    } else {
+        for (size_t i = 0; i < theta.size(); i++) {
+            beta[i] = pitch(theta[i]);
+        }
+    }
+}
+
+/**
+ * @brief the same pitch angle all around the turbine
+ */
+class ConstantPitch {
+  private:
+    double beta;
+
+  public:
+    /**
+     * @brief Construct a new ConstantPitch object
+     *
+     * @param beta - pitch angle in radians
+     */
+    explicit ConstantPitch(double beta) : beta(beta) {}
+
+    double operator()(double) const { return this->beta; }
+    void operator()(std::span<const double> theta,
+                    std::span<double> beta) const;
+};
+
+/**
+ * @brief pitch angle as a Fourier series in theta
+ *
+ * `beta(theta) = a_0 + sum_k a_k cos(k theta) + b_k sin(k theta)`, with
+ * `k = 1, 2, ...`. The harmonics are computed by rotating the first one, so
+ * each angle costs one `sin` and one `cos` regardless of the order.
+ */
+class FourierPitch {
+  private:
+    double a_0;
+    std::vector<double> a;
+    std::vector<double> b;
+
+  public:
+    /**
+     * @brief Construct a new FourierPitch object
+     *
+     * The shorter coefficient list is padded with zeros.
+     *
+     * @param a_0 - mean pitch angle in radians
+     * @param a - cosine coefficients of the harmonics 1, 2, ...
+     * @param b - sine coefficients of the harmonics 1, 2, ...
+     */
+    FourierPitch(double a_0, std::vector<double> a, std::vector<double> b);
+
+    double operator()(double theta) const;
+    void operator()(std::span<const double> theta,
+                    std::span<double> beta) const;
+};
+
+/**
+ * @brief pitch angle interpolated linearly from a table, periodic in theta
+ */
+class TabulatedPitch {
+  private:
+    // the table with one wrapped point added on each end
+    std::vector<double> theta;
+    std::vector<double> beta;
+
+    /**
+     * @brief index of the table interval containing `theta`, which must be
+     * in `[0, 2 PI)`
+     *
+     * @param theta
+     * @param hint - an index at or before the interval
+     * @return size_t
+     */
+    size_t locate(double theta, size_t hint) const;
+
+    /**
+     * @brief interpolate within interval `i`
+     *
+     * @param i
+     * @param theta
+     * @return double
+     */
+    double interpolate(size_t i, double theta) const;
+
+  public:
+    /**
+     * @brief Construct a new TabulatedPitch object
+     *
+     * @param theta - strictly increasing locations in `[0, 2 PI)`, in radians
+     * @param beta - pitch angle at each location, in radians
+     */
+    TabulatedPitch(std::vector<double> theta, std::vector<double> beta);
+
+    double operator()(double theta) const;
+    void operator()(std::span<const double> theta,
+                    std::span<double> beta) const;
+};
+
+} // namespace vawt
@@ -0,0 +1,170 @@
+#include "polar_cache.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace vawt {
+
+const char CACHE_MAGIC[8] = {'V', 'A', 'W', 'T', 'P', 'O', 'L', 'R'};
+const uint32_t CACHE_VERSION = 1;
+const uint32_t CACHE_SYMMETRIC = 1;
+
+/**
+ * @brief the header at the start of each cache file
+ *
+ * The coefficients follow directly after the header. Its size is a multiple
+ * of 8, so they are correctly aligned in the mapping.
+ */
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t hash;
+    uint64_t n_alpha;
+    uint64_t n_re;
+    double alpha_0;
+    double d_alpha;
+    double log_re_0;
+    double d_log_re;
+};
+
+static_assert(sizeof(CacheHeader) % sizeof(double) == 0);
+
+ContentHash& ContentHash::add(const void* data, size_t len) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < len; i++) {
+        this->state ^= bytes[i];
+        this->state *= 1099511628211ull;
+    }
+    return *this;
+}
+
+ContentHash& ContentHash::add_file(string_view file) {
+    ifstream in{string(file), ios::binary};
+    if (!in) {
+        throw "could not read polar source file";
+    }
+    string content((istreambuf_iterator<char>(in)),
+                   istreambuf_iterator<char>());
+    return this->add((uint64_t)content.size()).add(content);
+}
+
+void write_file(string_view file, const function<void(ostream&)>& write,
+                const char* error) {
+    string tmp = string(file) + ".tmp";
+    try {
+        {
+            ofstream out(tmp, ios::binary | ios::trunc);
+            write(out);
+            out.close();
+            if (!out) {
+                throw error;
+            }
+        }
+        if (rename(tmp.c_str(), string(file).c_str()) != 0) {
+            throw error;
+        }
+    } catch (...) {
+        remove(tmp.c_str());
+        throw;
+    }
+}
+
+void write_polar_cache(string_view file, uint64_t hash, bool symmetric,
+                       const PolarTable& table) {
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.flags = symmetric ? CACHE_SYMMETRIC : 0;
+    header.hash = hash;
+    header.n_alpha = table.n_alpha();
+    header.n_re = table.n_re();
+    header.alpha_0 = table.alpha_0();
+    header.d_alpha = table.d_alpha();
+    header.log_re_0 = table.log_re_0();
+    header.d_log_re = table.d_log_re();
+
+    write_file(
+        file,
+        [&](ostream& out) {
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(table.data()),
+                      table.size_bytes());
+        },
+        "could not write polar cache file");
+}
+
+shared_ptr<const void> map_file(string_view file, size_t& len) {
+    int fd = open(string(file).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    len = st.st_size;
+    void* addr = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+    return shared_ptr<const void>(addr, [len](const void* p) {
+        munmap(const_cast<void*>(p), len);
+    });
+}
+
+bool valid_grid(size_t len, size_t header_len,
+                initializer_list<uint64_t> counts,
+                initializer_list<double> spacings) {
+    for (double d : spacings) {
+        if (!(isfinite(d) && d > 0.0)) {
+            return false;
+        }
+    }
+    size_t size = 2 * sizeof(double);
+    for (uint64_t n : counts) {
+        if (n != 0 && size > SIZE_MAX / n) {
+            return false;
+        }
+        size *= n;
+    }
+    return len >= header_len && len - header_len == size;
+}
+
+optional<PolarCache> map_polar_cache(string_view file) {
+    size_t len = 0;
+    shared_ptr<const void> mapping = map_file(file, len);
+    if (!mapping || len < sizeof(CacheHeader)) {
+        return nullopt;
+    }
+
+    auto header = static_cast<const CacheHeader*>(mapping.get());
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CACHE_VERSION || header->n_alpha < 2 ||
+        header->n_re < 2 ||
+        !valid_grid(len, sizeof(CacheHeader), {header->n_alpha, header->n_re},
+                    {header->d_alpha, header->d_log_re})) {
+        return nullopt;
+    }
+    auto values = reinterpret_cast<const double*>(header + 1);
+    PolarTable table(header->alpha_0, header->d_alpha, header->log_re_0,
+                     header->d_log_re, header->n_alpha, header->n_re,
+                     std::move(mapping), values);
+    return PolarCache{header->hash, (header->flags & CACHE_SYMMETRIC) != 0,
+                      std::move(table)};
+}
+
+} // namespace vawt
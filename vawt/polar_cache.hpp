@@ -0,0 +1,139 @@
+#pragma once
+
+#include "polar_table.hpp"
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace vawt {
+
+/**
+ * @brief 64 bit FNV-1a hash over everything a polar is built from
+ *
+ * Used to detect stale polar cache files.
+ */
+class ContentHash {
+  private:
+    uint64_t state = 14695981039346656037ull;
+
+  public:
+    /**
+     * @brief feed raw bytes into the hash
+     *
+     * @param data
+     * @param len
+     * @return ContentHash&
+     */
+    ContentHash& add(const void* data, size_t len);
+    ContentHash& add(std::string_view s) {
+        return this->add(s.data(), s.size());
+    }
+    ContentHash& add(double v) { return this->add(&v, sizeof(v)); }
+    ContentHash& add(uint64_t v) { return this->add(&v, sizeof(v)); }
+
+    /**
+     * @brief feed the whole content of a file into the hash
+     *
+     * @param file
+     * @return ContentHash&
+     */
+    ContentHash& add_file(std::string_view file);
+
+    uint64_t value() const { return this->state; }
+};
+
+/**
+ * @brief a polar table read from a cache file
+ */
+struct PolarCache {
+    /**
+     * @brief content hash of the sources the table was built from
+     */
+    uint64_t hash;
+
+    /**
+     * @brief is the aerofoil profile symmetric
+     */
+    bool symmetric;
+
+    /**
+     * @brief the coefficients, backed by the memory mapped file
+     */
+    PolarTable table;
+};
+
+/**
+ * @brief write a whole file through a temporary file, which is renamed to
+ * `file` once it is complete
+ *
+ * Concurrent readers never see a partial file. When `write` throws or the
+ * file can not be written, the temporary file is removed and the exception,
+ * or `error`, is thrown.
+ *
+ * @param file
+ * @param write - `Fn(out: std::ostream&)`, writes the content
+ * @param error - thrown when the file can not be written
+ */
+void write_file(std::string_view file,
+                const std::function<void(std::ostream&)>& write,
+                const char* error);
+
+/**
+ * @brief write a polar table to a versioned binary cache file
+ *
+ * The file is a fixed size header followed by the interleaved coefficients in
+ * native byte order, so it can be memory mapped and used as is. It is written
+ * to a temporary file first and then renamed, concurrent readers never see a
+ * partial file.
+ *
+ * @param file
+ * @param hash - content hash of the sources
+ * @param symmetric
+ * @param table
+ */
+void write_polar_cache(std::string_view file, uint64_t hash, bool symmetric,
+                       const PolarTable& table);
+
+/**
+ * @brief memory map a whole file read only
+ *
+ * @param file
+ * @param len - output, size of the file in bytes
+ * @return std::shared_ptr<const void> - the start of the mapping, which is
+ * released with the last copy. `nullptr` when the file does not exist or
+ * can not be mapped
+ */
+std::shared_ptr<const void> map_file(std::string_view file, size_t& len);
+
+/**
+ * @brief check the grid in the header of a mapped table file
+ *
+ * @param len - size of the file in bytes
+ * @param header_len - size of its header in bytes
+ * @param counts - grid points along each axis
+ * @param spacings - grid spacings along each axis
+ * @return true - all spacings are finite and positive and the file holds
+ * exactly the header and a pair of `double`s per grid point, whose total
+ * size does not overflow
+ */
+bool valid_grid(size_t len, size_t header_len,
+                std::initializer_list<uint64_t> counts,
+                std::initializer_list<double> spacings);
+
+/**
+ * @brief memory map a polar cache file
+ *
+ * The returned table references the mapping directly; nothing is copied. The
+ * mapping is released when the last copy of the table is destroyed.
+ *
+ * @param file
+ * @return std::optional<PolarCache> - empty when the file does not exist or
+ * is not a valid cache file of the current version
+ */
+std::optional<PolarCache> map_polar_cache(std::string_view file);
+
+} // namespace vawt
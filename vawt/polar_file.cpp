@@ -0,0 +1,205 @@
+#include "polar_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <boost/math/constants/constants.hpp>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+namespace vawt {
+
+const double TO_RAD = boost::math::double_constants::pi / 180.0;
+const double NaN = numeric_limits<double>::quiet_NaN();
+const size_t MAX_COLUMNS = 32;
+
+/**
+ * @brief is `c` a field separator
+ *
+ * @param c
+ * @return true
+ * @return false
+ */
+static bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+/**
+ * @brief split the next token off `line`
+ *
+ * @param line - the remaining line, the token is removed from it
+ * @return string_view - empty when there are no more tokens
+ */
+static string_view next_token(string_view& line) {
+    size_t start = 0;
+    while (start < line.size() && is_separator(line[start])) {
+        start++;
+    }
+    size_t end = start;
+    while (end < line.size() && !is_separator(line[end])) {
+        end++;
+    }
+    string_view token = line.substr(start, end - start);
+    line.remove_prefix(end);
+    return token;
+}
+
+/**
+ * @brief parse a whole token as a number
+ *
+ * @param token
+ * @param value
+ * @return true - if the complete token is a number
+ */
+static bool parse_number(string_view token, double& value) {
+    if (!token.empty() && token.front() == '+') {
+        token.remove_prefix(1);
+    }
+    auto [ptr, ec] =
+        from_chars(token.data(), token.data() + token.size(), value);
+    return ec == errc() && ptr == token.data() + token.size() &&
+           !token.empty();
+}
+
+static bool iequals(string_view a, string_view b) {
+    return a.size() == b.size() &&
+           equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return tolower((unsigned char)x) == tolower((unsigned char)y);
+           });
+}
+
+/**
+ * @brief look for a reynolds number in a header line
+ *
+ * Understands `Re = 0.080 e 6` (XFOIL), `Re = 80000`, `Re: 80000` and
+ * `Reynolds Number: 80000`.
+ *
+ * @param line
+ * @return double - NaN when the line does not contain one
+ */
+static double header_re(string_view line) {
+    string_view token;
+    while (!(token = next_token(line)).empty()) {
+        if (!iequals(token, "re") && !iequals(token, "re=") &&
+            !iequals(token, "re:") && !iequals(token, "reynolds")) {
+            continue;
+        }
+        double value;
+        for (token = next_token(line); !token.empty();
+             token = next_token(line)) {
+            if (token == "=" || token == ":" || iequals(token, "number") ||
+                iequals(token, "number:") || iequals(token, "number=")) {
+                continue;
+            }
+            if (!parse_number(token, value)) {
+                break;
+            }
+            // XFOIL writes the exponent as a separate ` e 6`
+            string_view rest = line;
+            double exponent;
+            if (iequals(next_token(rest), "e") &&
+                parse_number(next_token(rest), exponent)) {
+                value *= pow(10.0, exponent);
+            }
+            return value;
+        }
+    }
+    return NaN;
+}
+
+DataRow parse_polar(string_view text) {
+    double re = NaN;
+    array<size_t, 3> columns = {0, 1, 2};
+    array<double, MAX_COLUMNS> fields;
+    vector<double> alpha, cl, cd;
+    size_t lines = count(text.begin(), text.end(), '\n') + 1;
+    alpha.reserve(lines);
+    cl.reserve(lines);
+    cd.reserve(lines);
+
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == string_view::npos ? text.size() : eol + 1);
+
+        size_t n = 0;
+        bool numeric = true;
+        string_view rest = line;
+        string_view token;
+        while (!(token = next_token(rest)).empty()) {
+            if (n == MAX_COLUMNS || !parse_number(token, fields[n])) {
+                numeric = false;
+                break;
+            }
+            n++;
+        }
+
+        if (numeric && n > *max_element(columns.begin(), columns.end())) {
+            alpha.push_back(fields[columns[0]] * TO_RAD);
+            cl.push_back(fields[columns[1]]);
+            cd.push_back(fields[columns[2]]);
+            continue;
+        }
+        if (numeric) {
+            // empty or too short lines
+            continue;
+        }
+
+        if (isnan(re)) {
+            re = header_re(line);
+        }
+        // a column header naming alpha, cl and cd
+        array<size_t, 3> named = {MAX_COLUMNS, MAX_COLUMNS, MAX_COLUMNS};
+        rest = line;
+        for (size_t i = 0; !(token = next_token(rest)).empty(); i++) {
+            if (iequals(token, "alpha")) {
+                named[0] = i;
+            } else if (iequals(token, "cl")) {
+                named[1] = i;
+            } else if (iequals(token, "cd")) {
+                named[2] = i;
+            }
+        }
+        if (*max_element(named.begin(), named.end()) < MAX_COLUMNS) {
+            columns = named;
+        }
+    }
+
+    if (!is_sorted(alpha.begin(), alpha.end())) {
+        vector<size_t> order(alpha.size());
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(),
+             [&alpha](size_t a, size_t b) { return alpha[a] < alpha[b]; });
+        vector<double> a, l, d;
+        for (size_t i : order) {
+            a.push_back(alpha[i]);
+            l.push_back(cl[i]);
+            d.push_back(cd[i]);
+        }
+        alpha = std::move(a);
+        cl = std::move(l);
+        cd = std::move(d);
+    }
+    return DataRow(re, std::move(alpha), std::move(cl), std::move(cd));
+}
+
+double re_from_filename(string_view file) {
+    string name = filesystem::path(file).filename().string();
+    for (size_t pos = name.rfind("Re"); pos != string::npos;
+         pos = (pos == 0) ? string::npos : name.rfind("Re", pos - 1)) {
+        const char* first = name.data() + pos + 2;
+        const char* last = name.data() + name.size();
+        double value;
+        if (first < last && isdigit((unsigned char)*first) &&
+            from_chars(first, last, value).ec == errc()) {
+            return value;
+        }
+    }
+    return NaN;
+}
+
+} // namespace vawt
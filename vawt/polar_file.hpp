@@ -0,0 +1,42 @@
+#pragma once
+
+#include "aerofoil.hpp"
+#include <string_view>
+
+namespace vawt {
+
+/**
+ * @brief parse the content of a polar file
+ *
+ * Lines are split at whitespace, `,` and `;`. Every line that consists of at
+ * least 3 numbers is a data point, everything else is treated as header text.
+ * This covers
+ *
+ * - plain csv files with the columns alpha (in degrees), cl, cd
+ * - XFOIL polar files (`.pol`), which state the reynolds number as
+ *   `Re = 0.080 e 6` in the header
+ * - QBlade polar exports, which state it as `Reynolds Number: 80000`
+ *
+ * When a header line names the columns (`alpha`, `cl` and `cd`, case
+ * insensitive) those columns are used, otherwise the first three.
+ *
+ * The numbers are parsed in place with `std::from_chars`, no temporary
+ * strings are allocated.
+ *
+ * @param text
+ * @return DataRow - (re, alpha in radians, cl, cd) sorted by alpha, re is NaN
+ * if the file does not state it
+ */
+DataRow parse_polar(std::string_view text);
+
+/**
+ * @brief the number following the last `Re` in a file name
+ *
+ * For example `NACA0018Re0080.data` results in `80`.
+ *
+ * @param file - file name or path
+ * @return double - NaN if the file name contains no such number
+ */
+double re_from_filename(std::string_view file);
+
+} // namespace vawt
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief natural logarithm of a positive, normal number
+ *
+ * Branch free and built from integer and floating point arithmetic only, so
+ * loops calling it vectorize. Accurate to a few ulp, which is far below what
+ * matters for locating a grid cell.
+ *
+ * @param x
+ * @return double
+ */
+inline double grid_log(double x) {
+    const double LN2 = 0.69314718055994530942;
+    const double SQRT2 = 1.41421356237309504880;
+    uint64_t bits = std::bit_cast<uint64_t>(x);
+    // biased exponent as a double, without an int to double conversion
+    double e = std::bit_cast<double>(0x4330000000000000ull | (bits >> 52)) -
+               (4503599627370496.0 + 1023.0);
+    // mantissa in [1, 2), then moved to [sqrt(1/2), sqrt(2))
+    double m = std::bit_cast<double>((bits & 0x000fffffffffffffull) |
+                                     0x3ff0000000000000ull);
+    double big = (double)(m > SQRT2);
+    m *= 1.0 - 0.5 * big;
+    e += big;
+    // log(m) = 2 atanh(s) with |s| < 0.172
+    double s = (m - 1.0) / (m + 1.0);
+    double s2 = s * s;
+    double p = 1.0 / 21.0;
+    p = p * s2 + 1.0 / 19.0;
+    p = p * s2 + 1.0 / 17.0;
+    p = p * s2 + 1.0 / 15.0;
+    p = p * s2 + 1.0 / 13.0;
+    p = p * s2 + 1.0 / 11.0;
+    p = p * s2 + 1.0 / 9.0;
+    p = p * s2 + 1.0 / 7.0;
+    p = p * s2 + 1.0 / 5.0;
+    p = p * s2 + 1.0 / 3.0;
+    p = p * s2 + 1.0;
+    return e * LN2 + 2.0 * s * p;
+}
+
+/**
+ * @brief Cl and Cd resampled on a uniform alpha / log(re) grid
+ *
+ * The coefficients are stored interleaved as `(cl, cd)` pairs in one
+ * contiguous array with alpha as the fastest running index. A lookup is pure
+ * index arithmetic: no search along either axis, and both coefficients come
+ * out of the same four cells.
+ *
+ * Outside of the grid the values are extrapolated as constants.
+ *
+ * A table may hold only some consecutive rows of a larger reynolds grid (see
+ * `j_0`). Between them its lookups see the same cells and weights as the
+ * whole grid, so they give the same results bit for bit.
+ *
+ * The coefficients are stored as `Scalar`. The grid cell is always located
+ * in double precision, the four cells are blended in `Scalar`. A `float`
+ * table takes half the memory, so twice as much of it stays in cache. The
+ * source polars have far fewer significant digits than a float.
+ *
+ * @tparam Scalar - `double` or `float`
+ */
+template <class Scalar> class BasicPolarTable {
+    template <class Other> friend class BasicPolarTable;
+
+  private:
+    double _alpha_0;
+    double _d_alpha;
+    double _log_re_0;
+    double _d_log_re;
+    size_t _n_alpha;
+    size_t _n_re;
+    // index of the first row on the reynolds grid
+    double _j_0;
+    std::shared_ptr<const void> owner;
+    const Scalar* values;
+
+  public:
+    /**
+     * @brief Construct a new PolarTable object owning its coefficients
+     *
+     * @param alpha_0 - first alpha grid point in radians
+     * @param d_alpha - alpha grid spacing in radians
+     * @param log_re_0 - natural logarithm of the first reynolds grid point
+     * @param d_log_re - grid spacing of log(re)
+     * @param n_alpha - number of alpha grid points (at least 2)
+     * @param n_re - number of reynolds grid points (at least 2)
+     * @param data - `n_re * n_alpha` interleaved `(cl, cd)` pairs, alpha is
+     * the fastest running index
+     * @param j_0 - index of the first row of `data` on the reynolds grid
+     * starting at `log_re_0`, 0 for a whole grid
+     */
+    BasicPolarTable(double alpha_0, double d_alpha, double log_re_0,
+                    double d_log_re, size_t n_alpha, size_t n_re,
+                    std::vector<Scalar> data, size_t j_0 = 0)
+        : _alpha_0(alpha_0), _d_alpha(d_alpha), _log_re_0(log_re_0),
+          _d_log_re(d_log_re), _n_alpha(n_alpha), _n_re(n_re),
+          _j_0((double)j_0) {
+        auto storage =
+            std::make_shared<const std::vector<Scalar>>(std::move(data));
+        this->values = storage->data();
+        this->owner = std::move(storage);
+    }
+
+    /**
+     * @brief Construct a new table with the coefficients of `other`
+     * converted to `Scalar`
+     *
+     * @param other
+     */
+    template <class Other>
+    explicit BasicPolarTable(const BasicPolarTable<Other>& other)
+        : BasicPolarTable(
+              other._alpha_0, other._d_alpha, other._log_re_0,
+              other._d_log_re, other._n_alpha, other._n_re,
+              std::vector<Scalar>(other.values,
+                                  other.values +
+                                      2 * other._n_alpha * other._n_re),
+              (size_t)other._j_0) {}
+
+    /**
+     * @brief Construct a new PolarTable object on top of memory it does not
+     * allocate itself (e.g. a memory mapped cache file)
+     *
+     * @param owner - keeps `values` alive as long as the table (or a copy of
+     * it) exists
+     * @param values - `2 * n_re * n_alpha` interleaved coefficients
+     */
+    BasicPolarTable(double alpha_0, double d_alpha, double log_re_0,
+                    double d_log_re, size_t n_alpha, size_t n_re,
+                    std::shared_ptr<const void> owner, const Scalar* values)
+        : _alpha_0(alpha_0), _d_alpha(d_alpha), _log_re_0(log_re_0),
+          _d_log_re(d_log_re), _n_alpha(n_alpha), _n_re(n_re), _j_0(0.0),
+          owner(std::move(owner)), values(values) {}
+
+    double alpha_0() const { return this->_alpha_0; }
+    double d_alpha() const { return this->_d_alpha; }
+    double log_re_0() const { return this->_log_re_0; }
+    double d_log_re() const { return this->_d_log_re; }
+    size_t n_alpha() const { return this->_n_alpha; }
+    size_t n_re() const { return this->_n_re; }
+    size_t j_0() const { return (size_t)this->_j_0; }
+
+    /**
+     * @brief the interleaved `(cl, cd)` coefficients
+     *
+     * @return const Scalar*
+     */
+    const Scalar* data() const { return this->values; }
+
+    /**
+     * @brief lift and drag coefficient at alpha and re
+     *
+     * @param alpha - angle of attack in radians
+     * @param re - reynolds number
+     * @return std::pair<double, double> - (cl, cd)
+     */
+    std::pair<double, double> operator()(double alpha, double re) const {
+        double x = std::clamp((alpha - this->_alpha_0) / this->_d_alpha, 0.0,
+                              (double)(this->_n_alpha - 1));
+        double y =
+            std::clamp((grid_log(re) - this->_log_re_0) / this->_d_log_re,
+                       this->_j_0, this->_j_0 + (double)(this->_n_re - 1));
+        // x, y >= 0, truncation is floor
+        double i = std::min((double)(int32_t)x, (double)(this->_n_alpha - 2));
+        double j = std::min((double)(int32_t)y,
+                            this->_j_0 + (double)(this->_n_re - 2));
+        Scalar tx = (Scalar)(x - i);
+        Scalar ty = (Scalar)(y - j);
+
+        const Scalar* p =
+            this->values +
+            2 * ((size_t)(j - this->_j_0) * this->_n_alpha + (size_t)i);
+        const Scalar* q = p + 2 * this->_n_alpha;
+        Scalar w00 = (Scalar(1) - tx) * (Scalar(1) - ty);
+        Scalar w10 = tx * (Scalar(1) - ty);
+        Scalar w01 = (Scalar(1) - tx) * ty;
+        Scalar w11 = tx * ty;
+        return std::pair<double, double>(
+            w00 * p[0] + w10 * p[2] + w01 * q[0] + w11 * q[2],
+            w00 * p[1] + w10 * p[3] + w01 * q[1] + w11 * q[3]);
+    }
+
+    /**
+     * @brief lift and drag coefficients for many points at once
+     *
+     * The cell search and blend run as one branch free loop the compiler can
+     * vectorize. For symmetric profiles alpha is folded with a sign mask.
+     * The results are bit for bit identical to the scalar lookup.
+     *
+     * @param alpha - angles of attack in radians
+     * @param re - reynolds numbers
+     * @param cl - output lift coefficients
+     * @param cd - output drag coefficients
+     * @param n - number of points
+     * @param symmetric - fold negative alpha onto the positive side
+     */
+    void eval(const double* __restrict alpha, const double* __restrict re,
+              double* __restrict cl, double* __restrict cd, size_t n,
+              bool symmetric) const {
+        const double fold = symmetric ? 1.0 : 0.0;
+        const double x_max = (double)(this->_n_alpha - 1);
+        const double y_min = this->_j_0;
+        const double y_max = this->_j_0 + (double)(this->_n_re - 1);
+        const double i_max = (double)(this->_n_alpha - 2);
+        const double j_max = this->_j_0 + (double)(this->_n_re - 2);
+        const size_t n_alpha = this->_n_alpha;
+        const Scalar* __restrict values = this->values;
+
+        for (size_t k = 0; k < n; k++) {
+            double a = alpha[k];
+            double sgn = 1.0 - 2.0 * fold * (double)(a < 0.0);
+            a *= sgn;
+            double x = std::clamp((a - this->_alpha_0) / this->_d_alpha, 0.0,
+                                  x_max);
+            double y = std::clamp(
+                (grid_log(re[k]) - this->_log_re_0) / this->_d_log_re, y_min,
+                y_max);
+            double i = std::min((double)(int32_t)x, i_max);
+            double j = std::min((double)(int32_t)y, j_max);
+            Scalar tx = (Scalar)(x - i);
+            Scalar ty = (Scalar)(y - j);
+
+            size_t p = 2 * ((size_t)(j - y_min) * n_alpha + (size_t)i);
+            size_t q = p + 2 * n_alpha;
+            Scalar w00 = (Scalar(1) - tx) * (Scalar(1) - ty);
+            Scalar w10 = tx * (Scalar(1) - ty);
+            Scalar w01 = (Scalar(1) - tx) * ty;
+            Scalar w11 = tx * ty;
+            cl[k] = (double)(w00 * values[p] + w10 * values[p + 2] +
+                             w01 * values[q] + w11 * values[q + 2]) *
+                    sgn;
+            cd[k] = w00 * values[p + 1] + w10 * values[p + 3] +
+                    w01 * values[q + 1] + w11 * values[q + 3];
+        }
+    }
+
+    /**
+     * @brief memory used by the coefficient array in bytes
+     *
+     * @return size_t
+     */
+    size_t size_bytes() const {
+        return 2 * this->_n_alpha * this->_n_re * sizeof(Scalar);
+    }
+};
+
+/**
+ * @brief a polar table in double precision
+ */
+using PolarTable = BasicPolarTable<double>;
+
+/**
+ * @brief a polar table in single precision, see `BasicPolarTable`
+ */
+using SinglePolarTable = BasicPolarTable<float>;
+
+} // namespace vawt
@@ -0,0 +1,60 @@
+#include "polar_view.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <vector>
+
+using namespace std;
+
+namespace vawt {
+
+PolarView::PolarView(const Aerofoil* aerofoil, optional<PolarTable> table,
+                     double re_min, double re_max, double band_min,
+                     double band_max)
+    : aerofoil(aerofoil), table(std::move(table)),
+      symmetric(aerofoil->symmetric), re_min(re_min), re_max(re_max),
+      band_min(band_min), band_max(band_max) {}
+
+PolarView PolarView::slice(const Aerofoil& aerofoil, double re_min,
+                           double re_max) {
+    re_max = max(re_max, re_min);
+    // copy the table rows bracketing the band, on the grid of the full
+    // table, so lookups inside the band see the same cells and weights
+    auto copy_rows = [&](const auto& full) {
+        double y_min =
+            (grid_log(re_min) - full.log_re_0()) / full.d_log_re();
+        double y_max =
+            (grid_log(re_max) - full.log_re_0()) / full.d_log_re();
+        size_t last = full.n_re() - 1;
+        size_t j_0 = (size_t)clamp(floor(y_min), 0.0, (double)(last - 1));
+        // a lookup at y_max reads the row above floor(y_max)
+        size_t j_1 =
+            (size_t)clamp(floor(y_max) + 1.0, (double)(j_0 + 1), (double)last);
+        size_t row = 2 * full.n_alpha();
+        vector<double> data(full.data() + j_0 * row,
+                            full.data() + (j_1 + 1) * row);
+        PolarTable rows(full.alpha_0(), full.d_alpha(), full.log_re_0(),
+                        full.d_log_re(), full.n_alpha(), j_1 - j_0 + 1,
+                        std::move(data), j_0);
+        // at the ends of the full table the view clamps just like it
+        double lo = (j_0 == 0) ? 0.0 : re_min;
+        double hi = (j_1 == last) ? numeric_limits<double>::max() : re_max;
+        return PolarView(&aerofoil, std::move(rows), lo, hi, re_min, re_max);
+    };
+    if (aerofoil.table && !aerofoil.smooth) {
+        return copy_rows(*aerofoil.table);
+    }
+    if (aerofoil.single_table) {
+        // the view holds the rows in double precision, blending them gives
+        // the same coefficients up to float rounding
+        return copy_rows(*aerofoil.single_table);
+    }
+
+    // an empty lookup band, every lookup goes to the aerofoil
+    return PolarView(&aerofoil, nullopt, numeric_limits<double>::infinity(),
+                     -numeric_limits<double>::infinity(), re_min, re_max);
+}
+
+} // namespace vawt
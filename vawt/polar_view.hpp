@@ -0,0 +1,118 @@
+#pragma once
+
+#include "aerofoil.hpp"
+#include "polar_table.hpp"
+#include <optional>
+
+namespace vawt {
+
+/**
+ * @brief the polar of an Aerofoil restricted to a narrow reynolds band
+ *
+ * Within one case the local reynolds number only varies with the relative
+ * wind speed at the foil. A view holds just the part of the polar this band
+ * needs, on a grid small enough to stay in the L1 cache for a whole solve.
+ *
+ * When the aerofoil has a uniform grid the view is an exact copy of the
+ * table rows covering the band, in double precision also for a
+ * `SinglePolarTable`. Smooth aerofoils and aerofoils without a uniform grid
+ * are not sliced, resampling them would change their coefficients. The view
+ * passes all their lookups on to the aerofoil.
+ *
+ * Lookups outside the band are passed on to the aerofoil.
+ */
+class PolarView {
+  private:
+    const Aerofoil* aerofoil;
+    // empty when the aerofoil is not sliced
+    std::optional<PolarTable> table;
+    bool symmetric;
+    double re_min;
+    double re_max;
+    double band_min;
+    double band_max;
+
+    PolarView(const Aerofoil* aerofoil, std::optional<PolarTable> table,
+              double re_min, double re_max, double band_min, double band_max);
+
+  public:
+    /**
+     * @brief create a view on `aerofoil` for reynolds numbers in
+     * `[re_min, re_max]`
+     *
+     * The aerofoil must outlive the view.
+     *
+     * @param aerofoil
+     * @param re_min
+     * @param re_max
+     * @return PolarView
+     */
+    static PolarView slice(const Aerofoil& aerofoil, double re_min,
+                           double re_max);
+
+    /**
+     * @brief lift and drag coefficients
+     *
+     * @param alpha
+     * @param re
+     * @return ClCd
+     */
+    ClCd cl_cd(double alpha, double re) const {
+        if (this->symmetric) {
+            return this->cl_cd<Symmetric>(alpha, re);
+        }
+        return this->cl_cd<Asymmetric>(alpha, re);
+    }
+
+    /**
+     * @brief lift and drag coefficients with the symmetry known at compile
+     * time, see `Aerofoil::cl_cd<Symmetry>`
+     *
+     * @tparam Symmetry
+     * @param alpha
+     * @param re
+     * @return ClCd
+     */
+    template <class Symmetry> ClCd cl_cd(double alpha, double re) const {
+        if (re < this->re_min || re > this->re_max) {
+            return this->aerofoil->cl_cd<Symmetry>(alpha, re);
+        }
+        double sgn = Symmetry::fold(alpha);
+        auto [cl, cd] = (*this->table)(alpha, re);
+        return ClCd(cl * sgn, cd);
+    }
+
+    /**
+     * @brief is this a view on `aerofoil` that covers `[re_min, re_max]`
+     *
+     * @param aerofoil
+     * @param re_min
+     * @param re_max
+     * @return true
+     * @return false
+     */
+    bool covers(const Aerofoil* aerofoil, double re_min, double re_max) const {
+        return this->aerofoil == aerofoil && this->band_min <= re_min &&
+               re_max <= this->band_max;
+    }
+
+    /**
+     * @brief does the view hold a slice of the polar, false when all lookups
+     * are passed on to the aerofoil
+     *
+     * @return true
+     * @return false
+     */
+    bool sliced() const { return this->table.has_value(); }
+
+    /**
+     * @brief memory used by the view's coefficients in bytes
+     *
+     * @return size_t
+     */
+    size_t size_bytes() const {
+        return this->table ? this->table->size_bytes() : 0;
+    }
+};
+
+} // namespace vawt
@@ -0,0 +1,140 @@
+#include "power_curve.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace vawt {
+
+/**
+ * @brief estimated error of the linear interpolation of `y` on each interval
+ * `[x[k], x[k + 1]]`, from the second divided differences at its ends
+ *
+ * @param x - at least 3 increasing samples
+ * @param y
+ * @return vector<double> - one per interval
+ */
+static vector<double> interval_errors(const vector<double>& x,
+                                      const vector<double>& y) {
+    size_t n = x.size();
+    // |y''| at the interior samples
+    vector<double> curvature(n, 0.0);
+    for (size_t i = 1; i + 1 < n; i++) {
+        double left = (y[i] - y[i - 1]) / (x[i] - x[i - 1]);
+        double right = (y[i + 1] - y[i]) / (x[i + 1] - x[i]);
+        curvature[i] = abs(2.0 * (right - left) / (x[i + 1] - x[i - 1]));
+    }
+    vector<double> errors(n - 1);
+    for (size_t k = 0; k + 1 < n; k++) {
+        double h = x[k + 1] - x[k];
+        errors[k] = h * h / 8.0 * max(curvature[k], curvature[k + 1]);
+    }
+    return errors;
+}
+
+double PowerCurve::operator()(double tsr) const {
+    const vector<double>& x = this->_tsr;
+    if (x.empty() || tsr < x.front() || tsr > x.back()) {
+        throw "tsr out of the range of the power curve";
+    }
+    size_t k = upper_bound(x.begin(), x.end(), tsr) - x.begin();
+    if (k == x.size()) {
+        return this->_c_power.back();
+    }
+    double t = (tsr - x[k - 1]) / (x[k] - x[k - 1]);
+    return this->_c_power[k - 1] +
+           t * (this->_c_power[k] - this->_c_power[k - 1]);
+}
+
+PowerCurve PowerCurveBuilder::build() {
+    if (this->_initial_points < 3 || !(this->tsr_min < this->tsr_max)) {
+        throw "a power curve needs at least 3 initial points on a non empty "
+              "range";
+    }
+    PowerCurve curve;
+    vector<double>& tsr = curve._tsr;
+    vector<double>& c_power = curve._c_power;
+    vector<VAWTSolution>& solutions = curve._solutions;
+
+    // solve `new_tsr`, warm started from `priors` where not `nullptr`
+    auto solve = [&](const vector<double>& new_tsr,
+                     const vector<const VAWTSolution*>& priors) {
+        vector<VAWTSolution> solved(new_tsr.size());
+        this->_pool->parallel_for(new_tsr.size(), [&](size_t i) {
+            VAWTSolver solver = this->solver;
+            solver.tsr(new_tsr[i]);
+            if (priors[i]) {
+                solver.warm_start(*priors[i]);
+            }
+            solver.solve_into(this->beta, VAWTSolver::thread_workspace(),
+                              solved[i]);
+        });
+        return solved;
+    };
+
+    size_t n = this->_initial_points;
+    tsr.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        tsr[i] = this->tsr_min + (this->tsr_max - this->tsr_min) *
+                                     (double)i / (double)(n - 1);
+    }
+    solutions = solve(tsr, vector<const VAWTSolution*>(n, nullptr));
+    for (VAWTSolution& solution : solutions) {
+        c_power.push_back(solution.c_power());
+    }
+
+    while (true) {
+        vector<double> errors = interval_errors(tsr, c_power);
+        curve._error = *max_element(errors.begin(), errors.end());
+        vector<size_t> refine;
+        for (size_t k = 0; k < errors.size(); k++) {
+            if (errors[k] > this->_tolerance &&
+                tsr[k + 1] - tsr[k] >= 2.0 * this->_min_spacing) {
+                refine.push_back(k);
+            }
+        }
+        size_t budget =
+            this->_max_solves - min(this->_max_solves, tsr.size());
+        if (refine.empty() || budget == 0) {
+            break;
+        }
+        if (refine.size() > budget) {
+            stable_sort(refine.begin(), refine.end(), [&](size_t l, size_t r) {
+                return errors[l] > errors[r];
+            });
+            refine.resize(budget);
+        }
+        sort(refine.begin(), refine.end());
+
+        vector<double> new_tsr;
+        vector<const VAWTSolution*> priors;
+        for (size_t k : refine) {
+            new_tsr.push_back(tsr[k] + (tsr[k + 1] - tsr[k]) / 2.0);
+            priors.push_back(&solutions[k]);
+        }
+        vector<VAWTSolution> solved = solve(new_tsr, priors);
+
+        // merge the new samples, each right after its interval's start
+        vector<double> merged_tsr, merged_c_power;
+        vector<VAWTSolution> merged_solutions;
+        size_t j = 0;
+        for (size_t k = 0; k < tsr.size(); k++) {
+            merged_tsr.push_back(tsr[k]);
+            merged_c_power.push_back(c_power[k]);
+            merged_solutions.push_back(std::move(solutions[k]));
+            if (j < refine.size() && refine[j] == k) {
+                merged_tsr.push_back(new_tsr[j]);
+                merged_c_power.push_back(solved[j].c_power());
+                merged_solutions.push_back(std::move(solved[j]));
+                j++;
+            }
+        }
+        tsr = std::move(merged_tsr);
+        c_power = std::move(merged_c_power);
+        solutions = std::move(merged_solutions);
+    }
+    return curve;
+}
+
+} // namespace vawt
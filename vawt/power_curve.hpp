@@ -0,0 +1,206 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include "vawt.hpp"
+#include <functional>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief the power coefficient as a function of the tip speed ratio, sampled
+ * by a `PowerCurveBuilder`
+ *
+ * Between the samples the curve is interpolated linearly.
+ */
+class PowerCurve {
+    friend class PowerCurveBuilder;
+
+  private:
+    std::vector<double> _tsr;
+    std::vector<double> _c_power;
+    std::vector<VAWTSolution> _solutions;
+    double _error = 0.0;
+
+  public:
+    /**
+     * @brief the sampled tip speed ratios, increasing
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& tsr() const { return this->_tsr; }
+
+    /**
+     * @brief the power coefficient at each sample
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& c_power() const { return this->_c_power; }
+
+    /**
+     * @brief the solution of each sample
+     *
+     * @return const std::vector<VAWTSolution>&
+     */
+    const std::vector<VAWTSolution>& solutions() const {
+        return this->_solutions;
+    }
+
+    /**
+     * @brief number of solves, the same as the number of samples
+     *
+     * @return size_t
+     */
+    size_t n_solves() const { return this->_tsr.size(); }
+
+    /**
+     * @brief the largest estimated interpolation error of any interval
+     * between samples, see `PowerCurveBuilder::tolerance`
+     *
+     * @return double
+     */
+    double error_estimate() const { return this->_error; }
+
+    /**
+     * @brief the interpolated power coefficient
+     *
+     * @param tsr - within the sampled range
+     * @return double
+     */
+    double operator()(double tsr) const;
+};
+
+/**
+ * @brief sample a `PowerCurve` adaptively
+ *
+ * The range of tip speed ratios is first sampled on a coarse uniform grid.
+ * Then every round estimates the error of the linear interpolation on each
+ * interval between samples from the curvature at its ends, `h^2 / 8 |Cp''|`.
+ * All intervals whose estimate exceeds the tolerance are bisected, most
+ * erroneous first, and the new samples of the round are solved in parallel.
+ * So the samples gather at the peak and the stall knee while the flat flanks
+ * stay coarse.
+ *
+ * Each new sample is warm started (see `VAWTSolver::warm_start`) from the
+ * solution of its lower neighbour. The samples of a round only depend on
+ * earlier rounds, the curve does not depend on the number of threads.
+ */
+class PowerCurveBuilder {
+  private:
+    VAWTSolver solver;
+    std::function<double(double)> beta = ConstantPitch(0.0);
+    double tsr_min = 1.0;
+    double tsr_max = 5.0;
+    size_t _initial_points = 9;
+    double _tolerance = 1e-3;
+    double _min_spacing = 1e-3;
+    size_t _max_solves = 200;
+    ThreadPool* _pool = &ThreadPool::shared();
+
+  public:
+    /**
+     * @brief Construct a new PowerCurveBuilder
+     *
+     * @param solver - aerofoil and solve settings, its tsr is replaced by the
+     * samples
+     */
+    explicit PowerCurveBuilder(VAWTSolver solver)
+        : solver(std::move(solver)) {}
+
+    /**
+     * @brief the pitch schedule of all samples, 0 by default
+     *
+     * @param beta - pitch angle as a function of theta
+     * @return PowerCurveBuilder&
+     */
+    PowerCurveBuilder& pitch(std::function<double(double)> beta) {
+        this->beta = std::move(beta);
+        return *this;
+    }
+
+    /**
+     * @brief the range of tip speed ratios to sample, `[1, 5]` by default
+     *
+     * @param tsr_min
+     * @param tsr_max
+     * @return PowerCurveBuilder&
+     */
+    PowerCurveBuilder& tsr_range(double tsr_min, double tsr_max) {
+        this->tsr_min = tsr_min;
+        this->tsr_max = tsr_max;
+        return *this;
+    }
+
+    /**
+     * @brief number of samples of the initial uniform grid, at least 3, 9 by
+     * default
+     *
+     * @param n
+     * @return PowerCurveBuilder&
+     */
+    PowerCurveBuilder& initial_points(size_t n) {
+        this->_initial_points = n;
+        return *this;
+    }
+
+    /**
+     * @brief the target interpolation error of the power coefficient, 1e-3
+     * by default
+     *
+     * The power coefficient of each solve is only as accurate as the
+     * `epsilon` of the solver allows. A tolerance below that noise spends
+     * the samples on it.
+     *
+     * @param tolerance
+     * @return PowerCurveBuilder&
+     */
+    PowerCurveBuilder& tolerance(double tolerance) {
+        this->_tolerance = tolerance;
+        return *this;
+    }
+
+    /**
+     * @brief intervals narrower than twice this are not bisected, so a kink
+     * in the curve does not draw samples forever, 1e-3 by default
+     *
+     * @param spacing
+     * @return PowerCurveBuilder&
+     */
+    PowerCurveBuilder& min_spacing(double spacing) {
+        this->_min_spacing = spacing;
+        return *this;
+    }
+
+    /**
+     * @brief stop refining after this many solves in total, 200 by default
+     *
+     * @param n
+     * @return PowerCurveBuilder&
+     */
+    PowerCurveBuilder& max_solves(size_t n) {
+        this->_max_solves = n;
+        return *this;
+    }
+
+    /**
+     * @brief run on `pool` instead of `ThreadPool::shared()`
+     *
+     * The pool must outlive the builder.
+     *
+     * @param pool
+     * @return PowerCurveBuilder&
+     */
+    PowerCurveBuilder& pool(ThreadPool& pool) {
+        this->_pool = &pool;
+        return *this;
+    }
+
+    /**
+     * @brief sample the curve until the tolerance or the solve limit is met
+     *
+     * @return PowerCurve
+     */
+    PowerCurve build();
+};
+
+} // namespace vawt
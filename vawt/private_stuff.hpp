@@ -1,6 +1,9 @@
 #pragma once
 
+#include "vawt.hpp"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <math.h>
 #include <utility>
 
@@ -17,4 +20,108 @@ inline std::pair<double, double> rot_vec(double x, double y, double alpha) {
     return std::pair<double, double>(cos(alpha) * x + sin(-alpha) * y,
                                      sin(alpha) * x + cos(alpha) * y);
 }
+
+/**
+ * @brief apply rotation around an angle with known cosine and sine to x, y,
+ * the same result as `rot_vec(x, y, alpha)`
+ *
+ * @param x
+ * @param y
+ * @param cos_alpha
+ * @param sin_alpha
+ * @return std::pair<double, double>
+ */
+inline std::pair<double, double> rot_vec(double x, double y, double cos_alpha,
+                                         double sin_alpha) {
+    return std::pair<double, double>(cos_alpha * x + -sin_alpha * y,
+                                     sin_alpha * x + cos_alpha * y);
+}
+
+/**
+ * @brief find a root of `f` with Brent's method
+ *
+ * Inverse quadratic interpolation or secant steps where they make progress,
+ * bisection steps otherwise.
+ *
+ * @param f - `Fn(x: double) -> double`
+ * @param a - one end of the bracket
+ * @param b - the other end of the bracket
+ * @param fa - `f(a)`
+ * @param fb - `f(b)`, of the opposite sign
+ * @param epsilon - stop once the bracket is narrower
+ * @param residual - stop once `|f(x)| <= residual`
+ * @param max_iterations - stop after this many calls of `f`
+ * @return TubeResult - the root, the number of calls of `f` and whether the
+ * tolerance was reached within `max_iterations`
+ */
+template <class Fn>
+TubeResult brent(Fn f, double a, double b, double fa, double fb,
+                 double epsilon, double residual, uint max_iterations) {
+    using std::abs;
+    // b is the current estimate, the root lies between b and c and a is the
+    // previous estimate
+    double c = b, fc = fb;
+    double d = b - a, e = d;
+    uint n = 0;
+    while (n < max_iterations) {
+        if ((fb > 0.0) == (fc > 0.0)) {
+            c = a;
+            fc = fa;
+            d = b - a;
+            e = d;
+        }
+        if (abs(fc) < abs(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        double tol =
+            2.0 * std::numeric_limits<double>::epsilon() * abs(b) +
+            0.5 * epsilon;
+        double m = 0.5 * (c - b);
+        if (abs(m) <= tol || abs(fb) <= residual) {
+            return TubeResult{b, n, true, true};
+        }
+        if (abs(e) >= tol && abs(fa) > abs(fb)) {
+            double s = fb / fa;
+            double p, q;
+            if (a == c) {
+                // secant
+                p = 2.0 * m * s;
+                q = 1.0 - s;
+            } else {
+                // inverse quadratic interpolation
+                double r = fb / fc;
+                double t = fa / fc;
+                p = s * (2.0 * m * t * (t - r) - (b - a) * (r - 1.0));
+                q = (t - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0.0) {
+                q = -q;
+            } else {
+                p = -p;
+            }
+            if (2.0 * p <
+                std::min(3.0 * m * q - abs(tol * q), abs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = m;
+                e = m;
+            }
+        } else {
+            d = m;
+            e = m;
+        }
+        a = b;
+        fa = fb;
+        b += (abs(d) > tol) ? d : std::copysign(tol, m);
+        fb = f(b);
+        n++;
+    }
+    return TubeResult{b, n, false, true};
+}
 } // namespace vawt
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "rotor_geometry.hpp"
+
+#include <algorithm>
+#include <boost/math/constants/constants.hpp>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+namespace vawt {
+
+RotorGeometry::RotorGeometry(uint n_streamtubes)
+    : n(n_streamtubes), _theta(n_streamtubes), _cos_theta(n_streamtubes),
+      _sin_theta(n_streamtubes), _width(n_streamtubes) {
+    const double pi = boost::math::double_constants::pi;
+    auto d_t_half = pi / (double)n_streamtubes;
+    generate(this->_theta.begin(), this->_theta.end(),
+             [i = d_t_half, d_t = 2.0 * d_t_half]() mutable {
+                 double current = i;
+                 i += d_t;
+                 return current;
+             });
+    for (size_t i = 0; i < this->n; i++) {
+        this->_cos_theta[i] = cos(this->_theta[i]);
+        this->_sin_theta[i] = sin(this->_theta[i]);
+        this->_width[i] = pi * abs(this->_sin_theta[i]);
+    }
+}
+
+shared_ptr<const RotorGeometry> RotorGeometry::get(uint n_streamtubes) {
+    static mutex cache_mutex;
+    static map<uint, shared_ptr<const RotorGeometry>> cache;
+    lock_guard lock(cache_mutex);
+    auto& geometry = cache[n_streamtubes];
+    if (!geometry) {
+        geometry.reset(new RotorGeometry(n_streamtubes));
+    }
+    return geometry;
+}
+
+} // namespace vawt
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief the streamtube locations of a rotor discretization and the terms of
+ * the thrust balance that only depend on them
+ *
+ * A geometry only depends on the number of streamtubes and is immutable once
+ * built. `RotorGeometry::get` builds each one once and shares it between all
+ * solves and threads.
+ */
+class RotorGeometry {
+  private:
+    uint n;
+    std::vector<double> _theta;
+    std::vector<double> _cos_theta;
+    std::vector<double> _sin_theta;
+    std::vector<double> _width;
+
+    explicit RotorGeometry(uint n_streamtubes);
+
+  public:
+    /**
+     * @brief the shared geometry for `n_streamtubes` streamtubes
+     *
+     * Geometries are cached for the lifetime of the program, later calls with
+     * the same number of streamtubes return the same object. Safe to call
+     * from several threads.
+     *
+     * @param n_streamtubes
+     * @return std::shared_ptr<const RotorGeometry>
+     */
+    static std::shared_ptr<const RotorGeometry> get(uint n_streamtubes);
+
+    uint n_streamtubes() const { return this->n; }
+
+    /**
+     * @brief location of each streamtube in radians, in the order of
+     * increasing theta
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& theta() const { return this->_theta; }
+
+    /**
+     * @brief `cos(theta)` of each streamtube
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& cos_theta() const { return this->_cos_theta; }
+
+    /**
+     * @brief `sin(theta)` of each streamtube
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& sin_theta() const { return this->_sin_theta; }
+
+    /**
+     * @brief `PI |sin(theta)|` of each streamtube, proportional to its width
+     * across the wind. The foil thrust is divided by it.
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& width() const { return this->_width; }
+
+    /**
+     * @brief the streamtube on the other side of the rotor, the downwind
+     * partner of an upwind streamtube and the other way round
+     *
+     * @param i
+     * @return size_t
+     */
+    size_t partner(size_t i) const { return this->n - 1 - i; }
+};
+
+} // namespace vawt
@@ -0,0 +1,181 @@
+#include "smooth_polar.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace vawt {
+
+/**
+ * @brief monotone cubic (PCHIP) slopes for the points `(x[k], y[k * stride])`
+ *
+ * Interior slopes are the weighted harmonic mean of the neighbouring secants
+ * (Fritsch-Carlson), zero at local extrema. End slopes use the one sided
+ * three point formula, limited to keep the end intervals monotone.
+ *
+ * @param x
+ * @param y
+ * @param stride
+ * @param d - output, `x.size()` slopes written with `stride`
+ */
+static void pchip_slopes(const vector<double>& x, const double* y,
+                         size_t stride, double* d) {
+    size_t n = x.size();
+    if (n < 2) {
+        d[0] = 0.0;
+        return;
+    }
+    auto h = [&](size_t k) { return x[k + 1] - x[k]; };
+    auto delta = [&](size_t k) {
+        return (y[(k + 1) * stride] - y[k * stride]) / h(k);
+    };
+    if (n == 2) {
+        d[0] = d[stride] = delta(0);
+        return;
+    }
+
+    for (size_t k = 1; k < n - 1; k++) {
+        double d_0 = delta(k - 1);
+        double d_1 = delta(k);
+        if (d_0 * d_1 <= 0.0) {
+            d[k * stride] = 0.0;
+        } else {
+            double w_0 = 2.0 * h(k) + h(k - 1);
+            double w_1 = h(k) + 2.0 * h(k - 1);
+            d[k * stride] = (w_0 + w_1) / (w_0 / d_0 + w_1 / d_1);
+        }
+    }
+
+    auto end_slope = [](double h_0, double h_1, double d_0, double d_1) {
+        double d = ((2.0 * h_0 + h_1) * d_0 - h_0 * d_1) / (h_0 + h_1);
+        if (d * d_0 <= 0.0) {
+            return 0.0;
+        }
+        if (d_0 * d_1 <= 0.0 && fabs(d) > fabs(3.0 * d_0)) {
+            return 3.0 * d_0;
+        }
+        return d;
+    };
+    d[0] = end_slope(h(0), h(1), delta(0), delta(1));
+    d[(n - 1) * stride] =
+        end_slope(h(n - 2), h(n - 3), delta(n - 2), delta(n - 3));
+}
+
+/**
+ * @brief locate the interval of `v` in the sorted grid
+ *
+ * @param grid
+ * @param v - clamped to the grid range
+ * @param t - output, normalized position within the interval
+ * @param extrapolated - output, `v` was outside the grid
+ * @return size_t - index of the left interval end
+ */
+static size_t locate(const vector<double>& grid, double& v, double& t,
+                     bool& extrapolated) {
+    extrapolated = v < grid.front() || v > grid.back();
+    v = clamp(v, grid.front(), grid.back());
+    if (grid.size() < 2) {
+        t = 0.0;
+        return 0;
+    }
+    size_t i = upper_bound(grid.begin(), grid.end(), v) - grid.begin();
+    i = clamp(i, (size_t)1, grid.size() - 1) - 1;
+    t = (v - grid[i]) / (grid[i + 1] - grid[i]);
+    return i;
+}
+
+SmoothPolar::SmoothPolar(vector<double> alpha, vector<double> re,
+                         const vector<double>& cl, const vector<double>& cd)
+    : alpha(std::move(alpha)), re(std::move(re)) {
+    size_t n_alpha = this->alpha.size();
+    size_t n_re = this->re.size();
+    this->nodes.resize(6 * n_alpha * n_re);
+    for (size_t k = 0; k < n_alpha * n_re; k++) {
+        this->nodes[6 * k] = cl[k];
+        this->nodes[6 * k + 1] = cd[k];
+    }
+    for (size_t j = 0; j < n_re; j++) {
+        for (size_t c = 0; c < 2; c++) {
+            double* row = this->nodes.data() + 6 * j * n_alpha;
+            pchip_slopes(this->alpha, row + c, 6, row + 2 + c);
+        }
+    }
+    for (size_t i = 0; i < n_alpha; i++) {
+        for (size_t c = 0; c < 2; c++) {
+            double* column = this->nodes.data() + 6 * i;
+            pchip_slopes(this->re, column + c, 6 * n_alpha, column + 4 + c);
+        }
+    }
+}
+
+template <bool Derivatives>
+array<double, 6> SmoothPolar::evaluate(double alpha, double re) const {
+    double u, v;
+    bool out_alpha, out_re;
+    size_t i = locate(this->alpha, alpha, u, out_alpha);
+    size_t j = locate(this->re, re, v, out_re);
+    size_t n_alpha = this->alpha.size();
+    size_t i_1 = min(i + 1, n_alpha - 1);
+    size_t j_1 = min(j + 1, this->re.size() - 1);
+    double h_alpha = this->alpha[i_1] - this->alpha[i];
+    double h_re = this->re[j_1] - this->re[j];
+
+    // cubic Hermite basis (value, value, slope, slope) in both directions
+    double u2 = u * u, u3 = u2 * u;
+    double v2 = v * v, v3 = v2 * v;
+    array<double, 4> bu = {2 * u3 - 3 * u2 + 1, -2 * u3 + 3 * u2,
+                           (u3 - 2 * u2 + u) * h_alpha, (u3 - u2) * h_alpha};
+    array<double, 4> bv = {2 * v3 - 3 * v2 + 1, -2 * v3 + 3 * v2,
+                           (v3 - 2 * v2 + v) * h_re, (v3 - v2) * h_re};
+    array<double, 4> du, dv;
+    if constexpr (Derivatives) {
+        // derivatives of the basis with respect to alpha and re
+        double sa = (h_alpha > 0.0 && !out_alpha) ? 1.0 / h_alpha : 0.0;
+        double sr = (h_re > 0.0 && !out_re) ? 1.0 / h_re : 0.0;
+        du = {(6 * u2 - 6 * u) * sa, (-6 * u2 + 6 * u) * sa,
+              (3 * u2 - 4 * u + 1) * h_alpha * sa,
+              (3 * u2 - 2 * u) * h_alpha * sa};
+        dv = {(6 * v2 - 6 * v) * sr, (-6 * v2 + 6 * v) * sr,
+              (3 * v2 - 4 * v + 1) * h_re * sr, (3 * v2 - 2 * v) * h_re * sr};
+    }
+
+    array<double, 6> result = {};
+    const double* corners[2][2] = {
+        {&this->nodes[6 * (j * n_alpha + i)],
+         &this->nodes[6 * (j_1 * n_alpha + i)]},
+        {&this->nodes[6 * (j * n_alpha + i_1)],
+         &this->nodes[6 * (j_1 * n_alpha + i_1)]}};
+    for (size_t a = 0; a < 2; a++) {
+        for (size_t b = 0; b < 2; b++) {
+            const double* n = corners[a][b];
+            for (size_t c = 0; c < 2; c++) {
+                // value, alpha slope, re slope at this corner
+                double f = n[c], f_a = n[2 + c], f_r = n[4 + c];
+                result[c] +=
+                    bu[a] * bv[b] * f + bu[2 + a] * bv[b] * f_a +
+                    bu[a] * bv[2 + b] * f_r;
+                if constexpr (Derivatives) {
+                    result[2 + c] += du[a] * bv[b] * f +
+                                     du[2 + a] * bv[b] * f_a +
+                                     du[a] * bv[2 + b] * f_r;
+                    result[4 + c] += bu[a] * dv[b] * f +
+                                     bu[2 + a] * dv[b] * f_a +
+                                     bu[a] * dv[2 + b] * f_r;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+pair<double, double> SmoothPolar::operator()(double alpha, double re) const {
+    auto result = this->evaluate<false>(alpha, re);
+    return pair(result[0], result[1]);
+}
+
+array<double, 6> SmoothPolar::derivatives(double alpha, double re) const {
+    return this->evaluate<true>(alpha, re);
+}
+
+} // namespace vawt
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief Cl and Cd as a C1 continuous surface over alpha and re
+ *
+ * Piecewise bicubic Hermite interpolation of the tabulated polar. The node
+ * slopes in both directions are monotone cubic (PCHIP, Fritsch-Carlson)
+ * estimates, so no overshoots are introduced between the data points and
+ * the first derivatives are continuous everywhere. Outside of the data the
+ * values are extrapolated as constants.
+ */
+class SmoothPolar {
+  private:
+    std::vector<double> alpha;
+    std::vector<double> re;
+
+    /**
+     * @brief per node: cl, cd, dcl/dalpha, dcd/dalpha, dcl/dre, dcd/dre
+     *
+     * re major, alpha minor
+     */
+    std::vector<double> nodes;
+
+    template <bool Derivatives>
+    std::array<double, 6> evaluate(double alpha, double re) const;
+
+  public:
+    /**
+     * @brief Construct a new SmoothPolar object
+     *
+     * @param alpha - the alpha grid in radians, sorted
+     * @param re - the reynolds grid, sorted
+     * @param cl - `re.size() * alpha.size()` lift coefficients, alpha is the
+     * fastest running index
+     * @param cd - drag coefficients, same layout as `cl`
+     */
+    SmoothPolar(std::vector<double> alpha, std::vector<double> re,
+                const std::vector<double>& cl, const std::vector<double>& cd);
+
+    /**
+     * @brief lift and drag coefficient at alpha and re
+     *
+     * @param alpha - angle of attack in radians
+     * @param re - reynolds number
+     * @return std::pair<double, double> - (cl, cd)
+     */
+    std::pair<double, double> operator()(double alpha, double re) const;
+
+    /**
+     * @brief lift and drag coefficient and their first derivatives
+     *
+     * Values and derivatives share the cell search and the Hermite basis, so
+     * the derivatives cost little more than the values alone.
+     *
+     * @param alpha - angle of attack in radians
+     * @param re - reynolds number
+     * @return std::array<double, 6> - (cl, cd, dcl/dalpha, dcd/dalpha,
+     * dcl/dre, dcd/dre)
+     */
+    std::array<double, 6> derivatives(double alpha, double re) const;
+};
+
+} // namespace vawt
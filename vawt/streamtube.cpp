@@ -1,8 +1,12 @@
 #include "streamtube.hpp"
 #include "private_stuff.hpp"
 #include "vawt.hpp"
+#include <algorithm>
 #include <boost/math/constants/constants.hpp>
 #include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
 
 using namespace std;
 
@@ -10,55 +14,316 @@ namespace vawt {
 
 const double PI = boost::math::double_constants::pi;
 
-StreamTube::Velocity StreamTube::Velocity::from_tangetial(double x, double y, double theta) {
-    auto [a, b] = rot_vec(x, y, theta);
+/**
+ * @brief iteration limit of the Strickland fallback
+ */
+const uint STRICKLAND_MAX_ITERATIONS = 50;
+
+/**
+ * @brief upper bound for the iterations of the root finders, on a valid
+ * bracket they all stop long before
+ */
+const uint MAX_ITERATIONS = 200;
+
+/**
+ * @brief half width of the initial bracket around a guess for a
+ */
+const double GUESS_WIDTH = 0.01;
+
+/**
+ * @brief narrow the bracket `[a_left, a_right]` around a guess for the root
+ *
+ * First `guess +- GUESS_WIDTH` is tried. When the sign does not change
+ * within it, it is widened geometrically towards the end of the bracket the
+ * sign change lies in.
+ *
+ * @param f - `Fn(a: double) -> double`
+ * @param guess
+ * @param a_left - updated in place
+ * @param a_right - updated in place
+ * @param err_left - `f(a_left)`, updated in place
+ * @param err_right - `f(a_right)`, updated in place
+ * @return uint - the number of evaluations of `f`
+ */
+template <class Fn>
+uint narrow_bracket(Fn f, double guess, double& a_left, double& a_right,
+                    double& err_left, double& err_right) {
+    double h = GUESS_WIDTH;
+    double lo = guess - h;
+    double hi = guess + h;
+    if (lo <= a_left || hi >= a_right) {
+        return 0;
+    }
+    double err_lo = f(lo);
+    double err_hi = f(hi);
+    uint n = 2;
+    if (err_lo * err_hi <= 0.0) {
+        a_left = lo;
+        a_right = hi;
+        err_left = err_lo;
+        err_right = err_hi;
+        return n;
+    }
+    if (err_left * err_lo <= 0.0) {
+        // the root lies left of the guess
+        while (true) {
+            h *= 4.0;
+            double a = guess - h;
+            if (a <= a_left) {
+                break;
+            }
+            double err = f(a);
+            n++;
+            if (err * err_lo <= 0.0) {
+                a_left = a;
+                err_left = err;
+                break;
+            }
+            lo = a;
+            err_lo = err;
+        }
+        a_right = lo;
+        err_right = err_lo;
+    } else {
+        // the root lies right of the guess
+        while (true) {
+            h *= 4.0;
+            double a = guess + h;
+            if (a >= a_right) {
+                break;
+            }
+            double err = f(a);
+            n++;
+            if (err * err_hi <= 0.0) {
+                a_right = a;
+                err_right = err;
+                break;
+            }
+            hi = a;
+            err_hi = err;
+        }
+        a_left = hi;
+        err_left = err_hi;
+    }
+    return n;
+}
+
+/**
+ * @brief find a root of `f` by bisection
+ *
+ * @param f - `Fn(a: double) -> double`
+ * @param a_left - left end of the bracket
+ * @param a_right - right end of the bracket
+ * @param err_left - `f(a_left)`
+ * @param epsilon - stop once the bracket is narrower
+ * @param residual - stop once `|f(a)| <= residual`
+ * @return TubeResult - the root, the number of iterations and whether the
+ * tolerance was reached within `MAX_ITERATIONS`
+ */
+template <class Fn>
+TubeResult bisection(Fn f, double a_left, double a_right, double err_left,
+                     double epsilon, double residual) {
+    uint n = 0;
+    while (n < MAX_ITERATIONS) {
+        if ((a_right - a_left) <= epsilon) {
+            return TubeResult{a_left + (a_right - a_left) / 2.0, n, true,
+                              true};
+        }
+        double a = a_left + (a_right - a_left) / 2.0;
+        double err = f(a);
+        n++;
+        if (abs(err) <= residual) {
+            return TubeResult{a, n, true, true};
+        }
+
+        if (err_left * err <= 0.0) {
+            a_right = a;
+        } else {
+            a_left = a;
+            err_left = err;
+        }
+    }
+    return TubeResult{a_left + (a_right - a_left) / 2.0, n, false,
+                      true};
+}
+
+/**
+ * @brief find a root of `f` with the Illinois variant of regula falsi
+ *
+ * Whenever the same end of the bracket is kept twice in a row, its function
+ * value is halved, so the other end moves as well. See `bisection` for the
+ * parameters.
+ */
+template <class Fn>
+TubeResult illinois(Fn f, double a_left, double a_right, double err_left,
+                    double err_right, double epsilon, double residual) {
+    uint n = 0;
+    int side = 0;
+    while (n < MAX_ITERATIONS) {
+        if ((a_right - a_left) <= epsilon) {
+            return TubeResult{a_left + (a_right - a_left) / 2.0, n, true,
+                              true};
+        }
+        double a = (a_left * err_right - a_right * err_left) /
+                   (err_right - err_left);
+        double err = f(a);
+        n++;
+        if (abs(err) <= residual) {
+            return TubeResult{a, n, true, true};
+        }
+        if (err * err_right > 0.0) {
+            a_right = a;
+            err_right = err;
+            if (side == -1) {
+                err_left /= 2.0;
+            }
+            side = -1;
+        } else {
+            a_left = a;
+            err_left = err;
+            if (side == 1) {
+                err_right /= 2.0;
+            }
+            side = 1;
+        }
+    }
+    return TubeResult{a_left + (a_right - a_left) / 2.0, n, false,
+                      true};
+}
+
+/**
+ * @brief find a root with Newton steps, safeguarded by a bracket
+ *
+ * A step that would leave the bracket is replaced by bisection. Besides the
+ * bracket and residual criteria it stops once a step is shorter than
+ * `epsilon / 2`.
+ *
+ * @param grad - `Fn(a: double) -> (f(a): double, f'(a): double)`
+ * @see bisection for the other parameters
+ */
+template <class Fn>
+TubeResult newton(Fn grad, double a_left, double a_right, double err_left,
+                  double epsilon, double residual) {
+    double a = a_left + (a_right - a_left) / 2.0;
+    uint n = 0;
+    while (n < MAX_ITERATIONS) {
+        auto [err, derr] = grad(a);
+        n++;
+        if (abs(err) <= residual) {
+            return TubeResult{a, n, true, true};
+        }
+        if (err * err_left > 0.0) {
+            a_left = a;
+        } else {
+            a_right = a;
+        }
+        double a_new = a - err / derr;
+        // also catches derr == 0
+        if (!(a_new > a_left && a_new < a_right)) {
+            a_new = a_left + (a_right - a_left) / 2.0;
+        }
+        double step = abs(a_new - a);
+        a = a_new;
+        if (step <= 0.5 * epsilon || (a_right - a_left) <= epsilon) {
+            return TubeResult{a, n, true, true};
+        }
+    }
+    return TubeResult{a, n, false, true};
+}
+
+StreamTube::StreamTube(double theta, double cos_theta, double sin_theta,
+                       double width, double beta, double a_0)
+    : a_0(a_0), theta(theta), beta(beta), cos_theta(cos_theta),
+      sin_theta(sin_theta), width(width) {
+    double r = -theta - beta;
+    this->cos_r = cos(r);
+    this->sin_r = sin(r);
+}
+
+StreamTube::Velocity StreamTube::Velocity::from_tangetial(double x, double y,
+                                                          double cos_theta,
+                                                          double sin_theta) {
+    auto [a, b] = rot_vec(x, y, cos_theta, sin_theta);
     return Velocity(a, b);
 }
 
-std::pair<double, double> StreamTube::Velocity::to_foil(double theta, double beta) {
-    return rot_vec(x, y, -theta - beta);
+std::pair<double, double>
+StreamTube::Velocity::to_foil(const StreamTube& tube) {
+    return rot_vec(x, y, tube.cos_r, tube.sin_r);
 }
 
 double StreamTube::Velocity::magnitude() {
     return sqrt(pow(x,2)+pow(y,2));
 }
 
-tuple<double, double, double> StreamTube::w_alpha_re(double a, VAWTCase case_) {
+tuple<double, double, double> StreamTube::w_alpha_re(double a,
+                                                     const VAWTCase& case_) {
     auto w = this->w_vec(a, case_);
-    auto [w_x_foil, w_y_foil] = w.to_foil(this->theta, this->beta);
+    auto [w_x_foil, w_y_foil] = w.to_foil(*this);
     auto alpha = atan2(w_y_foil, w_x_foil) + PI / 2.0;
     auto w_norm = w.magnitude();
     auto re = case_.re * w_norm;
     return tuple(w_norm, alpha, re);
 }
 
-double StreamTube::c_tan(double a, VAWTCase case_) {
+double StreamTube::thrust_error(double a, const VAWTCase& case_) {
+    if (case_.aerofoil->is_symmetric()) {
+        return this->thrust_error<Symmetric>(a, case_);
+    }
+    return this->thrust_error<Asymmetric>(a, case_);
+}
+
+double StreamTube::c_tan(double a, const VAWTCase& case_) {
+    if (case_.aerofoil->is_symmetric()) {
+        return this->c_tan<Symmetric>(a, case_);
+    }
+    return this->c_tan<Asymmetric>(a, case_);
+}
+
+template <class Symmetry>
+double StreamTube::c_tan(double a, const VAWTCase& case_) {
     auto [w, alpha, re] = this->w_alpha_re(a, case_);
     return get<1>(
-        case_.aerofoil->cl_cd(alpha, re).to_tangential(alpha, this->beta));
+        case_.cl_cd<Symmetry>(alpha, re).to_tangential(alpha, this->beta));
 }
 
-double StreamTube::a_strickland(VAWTCase case_) {
+template <class Symmetry>
+TubeResult StreamTube::a_strickland(const VAWTCase& case_, double epsilon) {
+    auto step = [&](double a) {
+        return min(0.25 * this->foil_thrust<Symmetry>(a, case_) + pow(a, 2),
+                   1.0);
+    };
     double a = 0.0;
-    for (int i = 0; i < 10; i++) {
-        auto c_s = this->foil_thrust(a, case_);
-        auto a_new = 0.25 * c_s + pow(a, 2);
-        if (a_new < 1.0) {
-            a = a_new;
+    uint n = 0;
+    while (n + 2 <= STRICKLAND_MAX_ITERATIONS) {
+        double a_1 = step(a);
+        double a_2 = step(a_1);
+        n += 2;
+        if (abs(a_2 - a_1) <= epsilon) {
+            return TubeResult{a_2, n, true, false};
+        }
+        // Aitken's delta squared extrapolation of the three iterates. It is
+        // only taken while the iteration contracts, otherwise it could jump
+        // to an unstable fixed point the plain iteration moves away from.
+        double ratio = (a_2 - a_1) / (a_1 - a);
+        double a_aitken = a - pow(a_1 - a, 2) / (a_2 - 2.0 * a_1 + a);
+        if (abs(ratio) < 1.0 && a_aitken >= -2.0 && a_aitken <= 1.0) {
+            a = a_aitken;
         } else {
-            a = 1.0;
+            a = a_2;
         }
     }
-    return a;
+    return TubeResult{a, n, false, false};
 }
 
-double StreamTube::foil_thrust(double a, VAWTCase case_) {
+template <class Symmetry>
+double StreamTube::foil_thrust(double a, const VAWTCase& case_) {
     auto [w, alpha, re] = this->w_alpha_re(a, case_);
 
-    auto cl_cd = case_.aerofoil->cl_cd(alpha, re);
+    auto cl_cd = case_.cl_cd<Symmetry>(alpha, re);
     auto [_, force_coeff] = cl_cd.to_global(alpha, this->beta, this->theta);
     return -force_coeff * pow(w / this->c_0(), 2) * case_.solidity /
-           (PI * abs(sin(this->theta)));
+           this->width;
 }
 
 double StreamTube::wind_thrust(double a) {
@@ -69,28 +334,297 @@ double StreamTube::wind_thrust(double a) {
     }
 }
 
-double StreamTube::solve_a(VAWTCase case_, double epsilon) {
+template <class Symmetry>
+pair<double, double> StreamTube::thrust_error_grad(double a,
+                                                   const VAWTCase& case_) {
+    auto [w_x, w_y] = this->w_vec(a, case_).to_foil(*this);
+    // only the wind at the foil depends on a: d(c_1_vec)/da = (0, c_0)
+    auto [dw_x, dw_y] = rot_vec(0.0, this->c_0(), this->cos_r, this->sin_r);
+    double w_sq = w_x * w_x + w_y * w_y;
+    double w = sqrt(w_sq);
+    double alpha = atan2(w_y, w_x) + PI / 2.0;
+    double dalpha = (w_x * dw_y - w_y * dw_x) / w_sq;
+    double dw = (w_x * dw_x + w_y * dw_y) / w;
+    double re = case_.re * w;
+    double dre = case_.re * dw;
+
+    auto grad = case_.cl_cd_grad<Symmetry>(alpha, re);
+    double cl = grad.cl();
+    double cd = grad.cd();
+    double dcl = grad.dcl_dalpha() * dalpha + grad.dcl_dre() * dre;
+    double dcd = grad.dcd_dalpha() * dalpha + grad.dcd_dre() * dre;
+
+    // global y component of the foil force, see `ClCd::to_global`
+    double phi = alpha + this->beta + this->theta;
+    double force = sin(phi) * cl - cos(phi) * cd;
+    double dforce =
+        cos(phi) * dalpha * cl + sin(phi) * dcl + sin(phi) * dalpha * cd -
+        cos(phi) * dcd;
+    double k = case_.solidity / (this->width * pow(this->c_0(), 2));
+    double foil = -force * w_sq * k;
+    double dfoil = -(dforce * w_sq + force * 2.0 * w * dw) * k;
+
+    double dwind = (a < 0.4) ? 4.0 - 8.0 * a : 26.0 / 15.0;
+    return pair(foil - StreamTube::wind_thrust(a), dfoil - dwind);
+}
+
+TubeResult StreamTube::solve_a(const VAWTCase& case_, RootFinder method,
+                               double epsilon, double residual, double guess) {
+    if (case_.aerofoil->is_symmetric()) {
+        return this->solve_a<Symmetric>(case_, method, epsilon, residual,
+                                        guess);
+    }
+    return this->solve_a<Asymmetric>(case_, method, epsilon, residual, guess);
+}
+
+template <class Symmetry>
+TubeResult StreamTube::solve_a(const VAWTCase& case_, RootFinder method,
+                               double epsilon, double residual, double guess) {
     double a_left = -2.0;
     double a_right = 2.0;
-    double err_left = 0.0;
-    double err_right = 0.0;
-    err_left = this->thrust_error(a_left, case_);
-    err_right = this->thrust_error(a_right, case_);
+    double err_left = this->thrust_error<Symmetry>(a_left, case_);
+    double err_right = this->thrust_error<Symmetry>(a_right, case_);
     if (err_left * err_right > 0.0) {
-        return this->a_strickland(case_);
+        return this->a_strickland<Symmetry>(case_, epsilon);
     }
-    while ((a_right - a_left) > epsilon) {
-        double a = a_left + (a_right - a_left) / 2.0;
-        double err = this->thrust_error(a, case_);
+    auto f = [&](double a) { return this->thrust_error<Symmetry>(a, case_); };
+    uint n = 0;
+    if (!isnan(guess)) {
+        n = narrow_bracket(f, guess, a_left, a_right, err_left, err_right);
+    }
+    TubeResult result;
+    switch (method) {
+    case RootFinder::Brent:
+        result = brent(f, a_left, a_right, err_left, err_right, epsilon,
+                       residual, MAX_ITERATIONS);
+        break;
+    case RootFinder::Illinois:
+        result = illinois(f, a_left, a_right, err_left, err_right, epsilon,
+                          residual);
+        break;
+    case RootFinder::Newton:
+        result = newton(
+            [&](double a) {
+                return this->thrust_error_grad<Symmetry>(a, case_);
+            },
+            a_left, a_right, err_left, epsilon, residual);
+        break;
+    default:
+        result = bisection(f, a_left, a_right, err_left, epsilon, residual);
+    }
+    result.iterations += n;
+    return result;
+}
 
-        if (err_left * err <= 0.0) {
-            a_right = a;
-            err_right = err;
-        } else {
-            a_left = a;
-            err_left = err;
+void StreamTubeBatch::resize(size_t n) {
+    for (vector<double>* v :
+         {&this->theta, &this->beta, &this->a_0, &this->case_re,
+          &this->solidity, &this->c_0, &this->t_x, &this->t_y, &this->cos_r,
+          &this->sin_r, &this->sin_nr, &this->denom, &this->a_left,
+          &this->a_right, &this->err_left, &this->err_right, &this->a,
+          &this->err, &this->w, &this->alpha, &this->re, &this->cl,
+          &this->cd}) {
+        v->resize(n);
+    }
+    this->cases.resize(n);
+    this->tube.resize(n);
+    this->narrowed.resize(n);
+    this->lanes.resize(n);
+}
+
+void StreamTubeBatch::set_lane(size_t i, const VAWTCase& case_, size_t tube,
+                               double beta, double a_0) {
+    const RotorGeometry& geometry = *this->geometry;
+    this->cases[i] = &case_;
+    this->tube[i] = tube;
+    this->theta[i] = geometry.theta()[tube];
+    this->beta[i] = beta;
+    this->a_0[i] = a_0;
+    this->case_re[i] = case_.re;
+    this->solidity[i] = case_.solidity;
+    this->c_0[i] = 1.0 - 2.0 * a_0;
+    // see `StreamTube::w_vec` and `StreamTube::Velocity::to_foil`
+    auto [t_x, t_y] = rot_vec(0.0, case_.tsr, geometry.cos_theta()[tube],
+                              geometry.sin_theta()[tube]);
+    this->t_x[i] = t_x;
+    this->t_y[i] = t_y;
+    double r = -this->theta[i] - beta;
+    this->cos_r[i] = cos(r);
+    this->sin_r[i] = sin(r);
+    this->sin_nr[i] = -this->sin_r[i];
+    this->denom[i] = geometry.width()[tube];
+}
+
+void StreamTubeBatch::reset(const VAWTCase& case_,
+                            const RotorGeometry& geometry, size_t first,
+                            span<const double> beta,
+                            span<const double> a_0) {
+    size_t n = beta.size();
+    if (a_0.size() != n) {
+        throw "StreamTubeBatch: all spans must have the same size";
+    }
+    if (first + n > geometry.n_streamtubes()) {
+        throw "StreamTubeBatch: streamtubes out of range";
+    }
+    this->lookup = &case_;
+    this->geometry = &geometry;
+    this->resize(n);
+    for (size_t i = 0; i < n; i++) {
+        this->set_lane(i, case_, first + i, beta[i], a_0[i]);
+    }
+}
+
+void StreamTubeBatch::reset(span<const VAWTCase> cases,
+                            const RotorGeometry& geometry,
+                            span<const size_t> tubes, span<const double> beta,
+                            span<const double> a_0) {
+    size_t n = cases.size() * tubes.size();
+    if (a_0.size() != n || beta.size() != geometry.n_streamtubes()) {
+        throw "StreamTubeBatch: all spans must have the same size";
+    }
+    for (size_t i : tubes) {
+        if (i >= geometry.n_streamtubes()) {
+            throw "StreamTubeBatch: streamtubes out of range";
+        }
+    }
+    for (const VAWTCase& case_ : cases) {
+        if (case_.aerofoil != cases[0].aerofoil || case_.polar) {
+            throw "StreamTubeBatch: the cases must share the aerofoil and "
+                  "not use a polar view";
+        }
+    }
+    this->lookup = cases.empty() ? nullptr : &cases[0];
+    this->geometry = &geometry;
+    this->resize(n);
+    for (size_t k = 0; k < cases.size(); k++) {
+        for (size_t j = 0; j < tubes.size(); j++) {
+            size_t i = k * tubes.size() + j;
+            this->set_lane(i, cases[k], tubes[j], beta[tubes[j]], a_0[i]);
+        }
+    }
+}
+
+void StreamTubeBatch::thrust_error(size_t n) {
+    // the operations of `StreamTube::thrust_error`, in the same order
+    for (size_t j = 0; j < n; j++) {
+        size_t i = this->lanes[j];
+        double w_x = 0.0 - this->t_x[i];
+        double w_y = -this->c_0[i] * (1.0 - this->a[j]) - this->t_y[i];
+        double w_x_foil = this->cos_r[i] * w_x + this->sin_nr[i] * w_y;
+        double w_y_foil = this->sin_r[i] * w_x + this->cos_r[i] * w_y;
+        this->alpha[j] = atan2(w_y_foil, w_x_foil) + PI / 2.0;
+        this->w[j] = sqrt(pow(w_x, 2) + pow(w_y, 2));
+        this->re[j] = this->case_re[i] * this->w[j];
+    }
+    this->lookup->cl_cd_batch(span<const double>(this->alpha.data(), n),
+                              span<const double>(this->re.data(), n),
+                              span<double>(this->cl.data(), n),
+                              span<double>(this->cd.data(), n));
+    for (size_t j = 0; j < n; j++) {
+        size_t i = this->lanes[j];
+        double phi = this->alpha[j] + this->beta[i] + this->theta[i];
+        double force = sin(phi) * this->cl[j] + cos(phi) * -this->cd[j];
+        double foil = -force * pow(this->w[j] / this->c_0[i], 2) *
+                      this->solidity[i] / this->denom[i];
+        this->err[j] = foil - StreamTube::wind_thrust(this->a[j]);
+    }
+}
+
+void StreamTubeBatch::solve_a(double epsilon, double residual,
+                              span<const double> guess,
+                              span<TubeResult> results) {
+    if (guess.size() != this->theta.size() ||
+        results.size() != this->theta.size()) {
+        throw "StreamTubeBatch: all spans must have the same size";
+    }
+    if (this->theta.empty()) {
+        return;
+    }
+    if (this->lookup->aerofoil->is_symmetric()) {
+        return this->solve_a<Symmetric>(epsilon, residual, guess, results);
+    }
+    return this->solve_a<Asymmetric>(epsilon, residual, guess, results);
+}
+
+template <class Symmetry>
+void StreamTubeBatch::solve_a(double epsilon, double residual,
+                              span<const double> guess,
+                              span<TubeResult> results) {
+    size_t n = this->theta.size();
+    fill(this->a_left.begin(), this->a_left.end(), -2.0);
+    fill(this->a_right.begin(), this->a_right.end(), 2.0);
+    fill(this->narrowed.begin(), this->narrowed.end(), 0);
+
+    // both ends of the initial bracket for all tubes at once
+    iota(this->lanes.begin(), this->lanes.end(), 0);
+    fill(this->a.begin(), this->a.end(), -2.0);
+    this->thrust_error(n);
+    copy(this->err.begin(), this->err.end(), this->err_left.begin());
+    fill(this->a.begin(), this->a.end(), 2.0);
+    this->thrust_error(n);
+    copy(this->err.begin(), this->err.end(), this->err_right.begin());
+
+    // the fallback and the bracket narrowing are sequential per tube
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        StreamTube tube(*this->geometry, this->tube[i], this->beta[i],
+                        this->a_0[i]);
+        const VAWTCase& case_ = *this->cases[i];
+        if (this->err_left[i] * this->err_right[i] > 0.0) {
+            results[i] = tube.a_strickland<Symmetry>(case_, epsilon);
+            continue;
+        }
+        if (!isnan(guess[i])) {
+            auto f = [&](double a) {
+                return tube.thrust_error<Symmetry>(a, case_);
+            };
+            this->narrowed[i] =
+                narrow_bracket(f, guess[i], this->a_left[i], this->a_right[i],
+                               this->err_left[i], this->err_right[i]);
+        }
+        this->lanes[m++] = i;
+    }
+
+    // lockstep `bisection`, every unfinished tube takes one step per round
+    uint steps = 0;
+    while (m > 0) {
+        size_t k = 0;
+        for (size_t j = 0; j < m; j++) {
+            size_t i = this->lanes[j];
+            double width = this->a_right[i] - this->a_left[i];
+            double mid = this->a_left[i] + width / 2.0;
+            if (steps >= MAX_ITERATIONS || width <= epsilon) {
+                results[i] = TubeResult{mid, steps + this->narrowed[i],
+                                        steps < MAX_ITERATIONS, true};
+                continue;
+            }
+            this->lanes[k] = i;
+            this->a[k] = mid;
+            k++;
+        }
+        m = k;
+        if (m == 0) {
+            break;
+        }
+        this->thrust_error(m);
+        steps++;
+        k = 0;
+        for (size_t j = 0; j < m; j++) {
+            size_t i = this->lanes[j];
+            if (abs(this->err[j]) <= residual) {
+                results[i] = TubeResult{this->a[j], steps + this->narrowed[i],
+                                        true, true};
+                continue;
+            }
+            if (this->err_left[i] * this->err[j] <= 0.0) {
+                this->a_right[i] = this->a[j];
+            } else {
+                this->a_left[i] = this->a[j];
+                this->err_left[i] = this->err[j];
+            }
+            this->lanes[k++] = i;
         }
+        m = k;
     }
-    return a_left + (a_right - a_left) / 2.0;
 }
-} // namespace vawt
\ No newline at end of file
+} // namespace vawt
@@ -1,19 +1,34 @@
 #pragma once
 
+#include "rotor_geometry.hpp"
 #include "vawt.hpp"
 #include <boost/math/constants/constants.hpp>
+#include <span>
+#include <vector>
 
 namespace vawt {
 class StreamTubeSolution;
+class StreamTubeBatch;
 
 class StreamTube {
     friend StreamTubeSolution;
+    friend StreamTubeBatch;
+    template <uint N> friend class FixedVAWTSolver;
 
   private:
     double a_0;
     double theta;
     double beta;
 
+    // the trigonometry of theta and of the rotation into the foil frame by
+    // `-theta - beta`, the thrust error is evaluated many times per tube
+    double cos_theta, sin_theta;
+    double width;
+    double cos_r, sin_r;
+
+    StreamTube(double theta, double cos_theta, double sin_theta, double width,
+               double beta, double a_0);
+
     /**
      * @brief the difference between the wind thrust and the foil force for a
      * given induction factor a.
@@ -22,8 +37,25 @@ class StreamTube {
      * @param case_ - case settings
      * @return double
      */
-    double thrust_error(double a, VAWTCase case_) {
-        return this->foil_thrust(a, case_) - StreamTube::wind_thrust(a);
+    double thrust_error(double a, const VAWTCase& case_);
+
+    /**
+     * @brief `thrust_error` with the symmetry of the aerofoil known at compile
+     * time
+     *
+     * Everything the root finder calls in its inner loop takes the symmetry
+     * policy as a template parameter, so the chain down to the polar lookup
+     * inlines without branching on it.
+     *
+     * @tparam Symmetry - `Symmetric` or `Asymmetric`
+     * @param a - induction factor
+     * @param case_ - case settings
+     * @return double
+     */
+    template <class Symmetry>
+    double thrust_error(double a, const VAWTCase& case_) {
+        return this->foil_thrust<Symmetry>(a, case_) -
+               StreamTube::wind_thrust(a);
     }
 
     /**
@@ -35,7 +67,8 @@ class StreamTube {
      * @param case_
      * @return std::tuple<double, double, double>
      */
-    std::tuple<double, double, double> w_alpha_re(double a, VAWTCase case_);
+    std::tuple<double, double, double> w_alpha_re(double a,
+                                                  const VAWTCase& case_);
 
     /**
      * @brief tangential foil coefficient
@@ -44,9 +77,44 @@ class StreamTube {
      * @param case_
      * @return double
      */
-    double c_tan(double a, VAWTCase case_);
-    double a_strickland(VAWTCase case_);
-    double foil_thrust(double a, VAWTCase case_);
+    double c_tan(double a, const VAWTCase& case_);
+    template <class Symmetry> double c_tan(double a, const VAWTCase& case_);
+
+    /**
+     * @brief fixed point iteration for a, used when the thrust error does not
+     * change its sign on the initial bracket
+     *
+     * The iteration `a = cs / 4 + a^2` (Strickland) is accelerated with
+     * Aitken's delta squared extrapolation and stops once successive
+     * iterates are closer than `epsilon`.
+     *
+     * @param case_
+     * @param epsilon
+     * @return TubeResult
+     */
+    template <class Symmetry>
+    TubeResult a_strickland(const VAWTCase& case_, double epsilon);
+    template <class Symmetry>
+    double foil_thrust(double a, const VAWTCase& case_);
+    template <class Symmetry>
+    TubeResult solve_a(const VAWTCase& case_, RootFinder method, double epsilon,
+                       double residual, double guess);
+
+    /**
+     * @brief the thrust error and its derivative by a
+     *
+     * The derivative follows the chain a -> w, alpha, re -> cl, cd with the
+     * polar derivatives from `VAWTCase::cl_cd_grad`, so the value is the
+     * same `thrust_error<Symmetry>` the bracket is built from.
+     *
+     * @tparam Symmetry
+     * @param a
+     * @param case_
+     * @return std::pair<double, double>
+     */
+    template <class Symmetry>
+    std::pair<double, double> thrust_error_grad(double a,
+                                                const VAWTCase& case_);
 
     /**
      * @brief Thrust coefficient by momentum theory or Glauert empirical formula
@@ -75,11 +143,12 @@ class StreamTube {
         static Velocity from_global(double x, double y) {
             return Velocity(x, y);
         }
-        static Velocity from_tangetial(double x, double y, double theta);
+        static Velocity from_tangetial(double x, double y, double cos_theta,
+                                       double sin_theta);
         Velocity operator-(Velocity rhs) {
             return Velocity(this->x - rhs.x, this->y - rhs.y);
         }
-        std::pair<double, double> to_foil(double theta, double beta);
+        std::pair<double, double> to_foil(const StreamTube& tube);
         double magnitude();
     };
 
@@ -100,9 +169,10 @@ class StreamTube {
      * @param case_
      * @return Velocity
      */
-    Velocity w_vec(double a, VAWTCase case_) {
-        return this->c_1_vec(a) -
-               Velocity::from_tangetial(0.0, case_.tsr, this->theta);
+    Velocity w_vec(double a, const VAWTCase& case_) {
+        return this->c_1_vec(a) - Velocity::from_tangetial(0.0, case_.tsr,
+                                                           this->cos_theta,
+                                                           this->sin_theta);
     }
 
   public:
@@ -114,24 +184,161 @@ class StreamTube {
      * @param a_0 - upstream induction factor when `theta < PI` this is probably
      * 0
      */
-    StreamTube(double theta, double beta, double a_0) {
-        this->a_0 = a_0;
-        this->beta = beta;
-        this->theta = theta;
-    }
+    StreamTube(double theta, double beta, double a_0)
+        : StreamTube(theta, std::cos(theta), std::sin(theta),
+                     boost::math::double_constants::pi *
+                         std::abs(std::sin(theta)),
+                     beta, a_0) {}
+
+    /**
+     * @brief Construct the streamtube `i` of `geometry`, with the
+     * trigonometry of its location taken from there
+     *
+     * @param geometry
+     * @param i - streamtube index
+     * @param beta - foil pitch angle (radians)
+     * @param a_0 - upstream induction factor
+     */
+    StreamTube(const RotorGeometry& geometry, size_t i, double beta,
+               double a_0)
+        : StreamTube(geometry.theta()[i], geometry.cos_theta()[i],
+                     geometry.sin_theta()[i], geometry.width()[i], beta,
+                     a_0) {}
 
     /**
      * @brief solve the streamtube for induction factor a
      *
      * @param case_
-     * @param epsilon
-     * @return double
+     * @param method - root finding strategy
+     * @param epsilon - stop once the bracket around a is narrower
+     * @param residual - stop once the thrust error is at most this
+     * @param guess - initial guess for a, `NaN` to search the whole bracket
+     * @return TubeResult
+     */
+    TubeResult solve_a(const VAWTCase& case_, RootFinder method, double epsilon,
+                       double residual, double guess = NAN);
+};
+
+/**
+ * @brief independent streamtubes of one case solved together by bisection
+ *
+ * All tubes of the batch bisect in lockstep. The terms of the thrust error
+ * that do not depend on a are computed once per tube and kept as a struct of
+ * arrays, each step then evaluates the unfinished tubes in one pass with a
+ * single batched polar lookup.
+ *
+ * Every tube goes through the same operations as `StreamTube::solve_a` with
+ * `RootFinder::Bisection`, the results are bit for bit the same.
+ */
+class StreamTubeBatch {
+  private:
+    const VAWTCase* lookup = nullptr;
+    const RotorGeometry* geometry = nullptr;
+
+    // per lane case and streamtube, a lane may belong to any case
+    std::vector<const VAWTCase*> cases;
+    std::vector<size_t> tube;
+    std::vector<double> theta, beta, a_0;
+    std::vector<double> case_re, solidity;
+
+    // per lane terms of the thrust error
+    std::vector<double> c_0;
+    std::vector<double> t_x, t_y;
+    std::vector<double> cos_r, sin_r, sin_nr;
+    std::vector<double> denom;
+
+    // per lane bisection state
+    std::vector<double> a_left, a_right, err_left, err_right;
+    std::vector<uint> narrowed;
+
+    // the unfinished lanes of the current step, compacted
+    std::vector<size_t> lanes;
+    std::vector<double> a, err, w, alpha, re, cl, cd;
+
+    /**
+     * @brief size the buffers for `n` lanes
+     *
+     * @param n
+     */
+    void resize(size_t n);
+
+    /**
+     * @brief set lane `i` to the streamtube `tube` of `geometry` in `case_`
+     *
+     * @param i - lane
+     * @param case_
+     * @param tube - streamtube index
+     * @param beta - foil pitch angle (radians)
+     * @param a_0 - upstream induction factor
+     */
+    void set_lane(size_t i, const VAWTCase& case_, size_t tube, double beta,
+                  double a_0);
+
+    /**
+     * @brief evaluate the thrust error of the first `n` entries of `lanes` at
+     * the induction factors in `a`, the results are written to `err`
+     *
+     * @param n
+     */
+    void thrust_error(size_t n);
+
+    template <class Symmetry>
+    void solve_a(double epsilon, double residual,
+                 std::span<const double> guess, std::span<TubeResult> results);
+
+  public:
+    /**
+     * @brief set the streamtubes to solve
+     *
+     * The batch solves the streamtubes `[first, first + beta.size())` of
+     * `geometry`, one per lane. The buffers of the batch are kept between
+     * calls, once they are large enough no more memory is allocated. `case_`
+     * and `geometry` must outlive the next `solve_a`.
+     *
+     * @param case_ - case settings
+     * @param geometry - the streamtube locations
+     * @param first - index of the first streamtube
+     * @param beta - foil pitch angles (radians)
+     * @param a_0 - upstream induction factors
+     */
+    void reset(const VAWTCase& case_, const RotorGeometry& geometry,
+               size_t first, std::span<const double> beta,
+               std::span<const double> a_0);
+
+    /**
+     * @brief set the streamtubes `tubes` of several cases to solve
+     *
+     * There is one lane for each streamtube of each case, the lane of
+     * `tubes[j]` in `cases[k]` is `k * tubes.size() + j`. The cases may differ
+     * in tip speed ratio, reynolds number and solidity, but must share the
+     * aerofoil and not use a polar view, all lanes are looked up in one
+     * batch. `cases` and `geometry` must outlive the next `solve_a`.
+     *
+     * @param cases - case settings
+     * @param geometry - the streamtube locations
+     * @param tubes - streamtube indices
+     * @param beta - foil pitch angle of each streamtube of `geometry`
+     * @param a_0 - upstream induction factor of each lane
+     */
+    void reset(std::span<const VAWTCase> cases, const RotorGeometry& geometry,
+               std::span<const size_t> tubes, std::span<const double> beta,
+               std::span<const double> a_0);
+
+    /**
+     * @brief solve all lanes for their induction factor
+     *
+     * @param epsilon - stop once the bracket around a is narrower
+     * @param residual - stop once the thrust error is at most this
+     * @param guess - initial guesses for a, `NaN` to search the whole bracket
+     * @param results - one per lane
      */
-    double solve_a(VAWTCase case_, double epsilon);
+    void solve_a(double epsilon, double residual,
+                 std::span<const double> guess, std::span<TubeResult> results);
 };
 
 class StreamTubeSolution {
     friend VAWTSolution;
+    template <uint N> friend class FixedSolution;
 
   private:
     VAWTCase case_;
@@ -183,7 +390,7 @@ class StreamTubeSolution {
      */
     double alpha() {
         auto [w_x_foil, w_y_foil] = this->tube.w_vec(this->a(), this->case_)
-                                        .to_foil(this->theta(), this->beta());
+                                        .to_foil(this->tube);
         return atan2(w_y_foil, w_x_foil) +
                boost::math::double_constants::pi / 2.0;
     }
@@ -0,0 +1,117 @@
+#include "sweep.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+
+using namespace std;
+
+namespace vawt {
+
+SweepRunner&
+SweepRunner::grid(const vector<double>& tsr, const vector<double>& re,
+                  const vector<double>& solidity,
+                  const vector<uint>& n_streamtubes,
+                  const vector<function<double(double)>>& beta) {
+    this->_cases.reserve(this->_cases.size() + tsr.size() * re.size() *
+                                                   solidity.size() *
+                                                   n_streamtubes.size() *
+                                                   beta.size());
+    for (const auto& beta_fn : beta) {
+        for (uint n : n_streamtubes) {
+            for (double s : solidity) {
+                for (double r : re) {
+                    for (double t : tsr) {
+                        this->_cases.push_back(SweepCase{t, r, s, n, beta_fn});
+                    }
+                }
+            }
+        }
+    }
+    return *this;
+}
+
+void SweepRunner::run(const Sink& sink) {
+    size_t n = this->_cases.size();
+    // solutions that finished ahead of an earlier case wait here, at most
+    // `window` of them
+    size_t window = this->window();
+    vector<optional<VAWTSolution>> ready(n);
+    mutex mutex;
+    condition_variable advanced;
+    size_t next = 0;
+    bool emitting = false;
+    // set by the first exception, nothing is solved or delivered after it
+    bool failed = false;
+    auto fail = [&]() {
+        lock_guard lock(mutex);
+        failed = true;
+        advanced.notify_all();
+    };
+
+    this->_pool->parallel_for(n, [&](size_t i) {
+        {
+            // the cases are claimed in order, so the case `next` is always
+            // being solved by a thread that does not wait here
+            unique_lock lock(mutex);
+            advanced.wait(lock, [&]() { return failed || i < next + window; });
+            if (failed) {
+                return;
+            }
+        }
+        const SweepCase& case_ = this->_cases[i];
+        VAWTSolver solver = this->solver;
+        solver.tsr(case_.tsr)
+            .re(case_.re)
+            .solidity(case_.solidity)
+            .n_streamtubes(case_.n_streamtubes);
+        VAWTSolution solution;
+        try {
+            solver.solve_into(case_.beta, VAWTSolver::thread_workspace(),
+                              solution);
+        } catch (...) {
+            fail();
+            throw;
+        }
+
+        unique_lock lock(mutex);
+        if (failed) {
+            return;
+        }
+        ready[i] = std::move(solution);
+        if (emitting) {
+            // the emitting thread picks it up
+            return;
+        }
+        emitting = true;
+        while (!failed && next < n && ready[next]) {
+            size_t k = next++;
+            VAWTSolution done = std::move(*ready[k]);
+            ready[k].reset();
+            advanced.notify_all();
+            lock.unlock();
+            try {
+                sink(k, this->_cases[k], done);
+            } catch (...) {
+                lock.lock();
+                emitting = false;
+                failed = true;
+                advanced.notify_all();
+                throw;
+            }
+            lock.lock();
+        }
+        emitting = false;
+    });
+}
+
+vector<VAWTSolution> SweepRunner::run() {
+    vector<VAWTSolution> solutions;
+    solutions.reserve(this->_cases.size());
+    this->run([&](size_t, const SweepCase&, VAWTSolution& solution) {
+        solutions.push_back(std::move(solution));
+    });
+    return solutions;
+}
+
+} // namespace vawt
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include "vawt.hpp"
+#include <functional>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief one operating point of a sweep
+ */
+struct SweepCase {
+    /**
+     * @brief Tipspeed ratio of the turbine
+     */
+    double tsr;
+
+    /**
+     * @brief Reynolds number of the turbine
+     */
+    double re;
+
+    /**
+     * @brief Turbine solidity
+     */
+    double solidity;
+
+    /**
+     * @brief number of streamtubes
+     */
+    uint n_streamtubes;
+
+    /**
+     * @brief pitch angle as a function of theta
+     */
+    std::function<double(double)> beta;
+};
+
+/**
+ * @brief solve many cases on a thread pool
+ *
+ * Each case is solved independently by a copy of the solver passed to the
+ * constructor, which also provides the aerofoil and the solve settings. All
+ * copies share the aerofoil read only. The solutions do not depend on the
+ * number of threads or the order the cases finish in.
+ */
+class SweepRunner {
+  private:
+    VAWTSolver solver;
+    std::vector<SweepCase> _cases;
+    ThreadPool* _pool = &ThreadPool::shared();
+
+  public:
+    /**
+     * @brief receives the solution of case `index`
+     *
+     * `Fn(index: size_t, case: const SweepCase&, solution: VAWTSolution&)`
+     */
+    using Sink = std::function<void(size_t, const SweepCase&, VAWTSolution&)>;
+
+    /**
+     * @brief Construct a new SweepRunner object
+     *
+     * @param solver - aerofoil and solve settings for all cases
+     */
+    explicit SweepRunner(VAWTSolver solver) : solver(std::move(solver)) {}
+
+    /**
+     * @brief add a single case
+     *
+     * @param case_
+     * @return SweepRunner&
+     */
+    SweepRunner& add(SweepCase case_) {
+        this->_cases.push_back(std::move(case_));
+        return *this;
+    }
+
+    /**
+     * @brief add the cartesian product of the parameter lists
+     *
+     * The tsr varies fastest, followed by re, solidity, n_streamtubes and
+     * beta.
+     *
+     * @param tsr
+     * @param re
+     * @param solidity
+     * @param n_streamtubes
+     * @param beta
+     * @return SweepRunner&
+     */
+    SweepRunner& grid(const std::vector<double>& tsr,
+                      const std::vector<double>& re,
+                      const std::vector<double>& solidity,
+                      const std::vector<uint>& n_streamtubes,
+                      const std::vector<std::function<double(double)>>& beta);
+
+    /**
+     * @brief run on `pool` instead of `ThreadPool::shared()`
+     *
+     * The pool must outlive the runner.
+     *
+     * @param pool
+     * @return SweepRunner&
+     */
+    SweepRunner& pool(ThreadPool& pool) {
+        this->_pool = &pool;
+        return *this;
+    }
+
+    /**
+     * @brief the most solutions `run` holds back for an earlier case, 4 per
+     * thread of the pool
+     *
+     * @return size_t
+     */
+    size_t window() const { return 4 * (this->_pool->size() + 1); }
+
+    /**
+     * @brief the cases in the order their solutions are delivered
+     *
+     * @return const std::vector<SweepCase>&
+     */
+    const std::vector<SweepCase>& cases() const { return this->_cases; }
+
+    /**
+     * @brief solve all cases and pass each solution to `sink`
+     *
+     * Solutions stream to `sink` while the sweep runs, always in the order of
+     * `cases`: a solution that finishes early is held back until all earlier
+     * ones are delivered. At most `window()` solutions are held back, a
+     * case further ahead waits before it is solved. `sink` is never called
+     * concurrently, but it may be called from any thread of the pool.
+     *
+     * The first exception thrown by a solve or by `sink` is rethrown once
+     * all started cases are finished. After it no further case is solved
+     * and no further solution is passed to `sink`.
+     *
+     * @param sink
+     */
+    void run(const Sink& sink);
+
+    /**
+     * @brief solve all cases
+     *
+     * @return std::vector<VAWTSolution> - in the order of `cases`
+     */
+    std::vector<VAWTSolution> run();
+};
+
+} // namespace vawt
@@ -0,0 +1,97 @@
+#include "thread_pool.hpp"
+
+using namespace std;
+
+namespace vawt {
+
+// the pool and the queue of the worker running on this thread
+static thread_local const ThreadPool* current_pool = nullptr;
+static thread_local size_t current_queue = 0;
+
+ThreadPool::ThreadPool(size_t n_threads) {
+    if (n_threads == 0) {
+        n_threads = max(thread::hardware_concurrency(), 1u);
+    }
+    for (size_t i = 0; i < n_threads; i++) {
+        this->queues.push_back(make_unique<Queue>());
+    }
+    for (size_t i = 0; i < n_threads; i++) {
+        this->workers.emplace_back([this, i]() { this->run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard lock(this->mutex);
+        this->stop = true;
+    }
+    this->cv.notify_all();
+    for (thread& worker : this->workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(function<void()> task) {
+    size_t index = (current_pool == this)
+                       ? current_queue
+                       : this->next_queue.fetch_add(1) % this->queues.size();
+    // counted first, a worker that sees the count but not yet the task just
+    // looks again
+    {
+        lock_guard lock(this->mutex);
+        this->pending++;
+    }
+    {
+        Queue& queue = *this->queues[index];
+        lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    this->cv.notify_one();
+}
+
+bool ThreadPool::take(size_t index, function<void()>& task) {
+    size_t n = this->queues.size();
+    for (size_t k = 0; k < n; k++) {
+        Queue& queue = *this->queues[(index + k) % n];
+        lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (k == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        this->pending--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    while (true) {
+        function<void()> task;
+        if (this->take(index, task)) {
+            task();
+            continue;
+        }
+        unique_lock lock(this->mutex);
+        this->cv.wait(lock, [this]() {
+            return this->stop || this->pending.load() > 0;
+        });
+        if (this->stop && this->pending.load() == 0) {
+            return;
+        }
+    }
+}
+
+} // namespace vawt
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief a fixed size pool of worker threads
+ *
+ * Every worker has its own task queue. Tasks submitted from a worker go to
+ * the back of its own queue and are taken from there in LIFO order, which
+ * keeps nested work on the thread that has its data in cache. An idle worker
+ * steals from the front of the other queues, oldest tasks first.
+ */
+class ThreadPool {
+  private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<size_t> next_queue{0};
+    // tasks submitted but not yet taken from a queue
+    std::atomic<size_t> pending{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+
+    /**
+     * @brief take a task, from the own queue of worker `index` first, then
+     * from the others
+     *
+     * @param index
+     * @param task - output
+     * @return true - a task was taken
+     * @return false - all queues are empty
+     */
+    bool take(size_t index, std::function<void()>& task);
+
+    /**
+     * @brief worker loop: run tasks until the pool is destroyed
+     *
+     * @param index - the worker's queue
+     */
+    void run(size_t index);
+
+  public:
+    /**
+     * @brief Construct a new ThreadPool object
+     *
+     * @param n_threads - number of worker threads, `0` uses one per hardware
+     * thread
+     */
+    explicit ThreadPool(size_t n_threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief a pool shared by the whole library, with one thread per hardware
+     * thread
+     *
+     * @return ThreadPool&
+     */
+    static ThreadPool& shared();
+
+    /**
+     * @brief number of worker threads
+     *
+     * @return size_t
+     */
+    size_t size() const { return this->workers.size(); }
+
+    /**
+     * @brief queue a task for execution on one of the workers
+     *
+     * @param task
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief call `fn(i)` for each `i` in `[0, n)` on the pool and wait for
+     * all calls to finish
+     *
+     * The calling thread takes part in the work, so nested calls from inside
+     * a task can not dead lock. The first exception thrown by `fn` is
+     * rethrown after all started calls have finished.
+     *
+     * @param n
+     * @param fn
+     */
+    template <class Fn> void parallel_for(size_t n, Fn&& fn) {
+        struct State {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::exception_ptr error;
+        };
+        if (n == 0) {
+            return;
+        }
+        auto state = std::make_shared<State>();
+        // `fn` is only touched after claiming an index below `n`, and the
+        // caller does not return before every claimed index is done.
+        auto work = [state, n, &fn]() {
+            size_t i;
+            while ((i = state->next.fetch_add(1)) < n) {
+                try {
+                    fn(i);
+                } catch (...) {
+                    std::lock_guard lock(state->mutex);
+                    if (!state->error) {
+                        state->error = std::current_exception();
+                    }
+                }
+                if (state->done.fetch_add(1) + 1 == n) {
+                    std::lock_guard lock(state->mutex);
+                    state->cv.notify_all();
+                }
+            }
+        };
+        size_t helpers = std::min(n, this->size() + 1) - 1;
+        for (size_t t = 0; t < helpers; t++) {
+            this->submit(work);
+        }
+        work();
+        std::unique_lock lock(state->mutex);
+        state->cv.wait(lock, [&]() { return state->done.load() == n; });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+};
+
+} // namespace vawt
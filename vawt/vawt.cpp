@@ -1,82 +1,439 @@
 #include "vawt.hpp"
 #include "Interpolators/_1D/LinearInterpolator.hpp"
 #include "streamtube.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <memory>
+#include <span>
 #include <tuple>
 #include <vector>
 
 namespace vawt {
 const double PI = boost::math::double_constants::pi;
 
+/**
+ * @brief largest relative change of tsr, re and solidity between two cases
+ * for which `continuation` reuses the solution of the first
+ */
+const double MAX_CONTINUATION_STEP = 0.1;
+
+/**
+ * @brief copy `from` into `to`, the aerofoil pointer only when it changed so
+ * that reusing a case does not touch its reference count
+ */
+static void assign_case(VAWTCase& to, const VAWTCase& from) {
+    to.re = from.re;
+    to.tsr = from.tsr;
+    to.solidity = from.solidity;
+    to.polar = from.polar;
+    if (to.aerofoil != from.aerofoil) {
+        to.aerofoil = from.aerofoil;
+    }
+}
+
+VAWTSolver::Workspace::Workspace() = default;
+VAWTSolver::Workspace::~Workspace() = default;
+VAWTSolver::Workspace::Workspace(Workspace&&) noexcept = default;
+VAWTSolver::Workspace&
+VAWTSolver::Workspace::operator=(Workspace&&) noexcept = default;
+
 VAWTSolution VAWTSolver::solve(double beta) {
-    return this->solve([beta](double theta) { return beta; });
+    return this->solve(ConstantPitch(beta));
 }
 
 VAWTSolution VAWTSolver::solve(std::function<double(double)> beta) {
-    return this->map_streamtubes([beta, this](VAWTCase case_, double theta_up,
-                                              double theta_down) {
-        double beta_up = beta(theta_up);
-        double beta_down = beta(theta_down);
-        double a_up =
-            StreamTube(theta_up, beta_up, 0.0).solve_a(case_, this->_epsilon);
-        double a_down = StreamTube(theta_down, beta_down, a_up)
-                            .solve_a(case_, this->_epsilon);
-        return std::tuple(beta_up, beta_down, a_up, a_down);
-    });
-}
-
-VAWTSolution VAWTSolver::map_streamtubes(
-    std::function<std::tuple<double, double, double, double>(VAWTCase, double,
-                                                             double)>
-        solve_fn) {
-    auto d_t_half = PI / (double)this->_n_streamtubes;
-    std::vector<double> theta(this->_n_streamtubes);
-    std::vector<double> beta(this->_n_streamtubes, 0.0);
-    std::vector<double> a(this->_n_streamtubes, 0.0);
-    std::vector<double> a_0(this->_n_streamtubes, 0.0);
-
-    std::generate(theta.begin(), theta.end(),
-                  [i = d_t_half, d_t = 2.0 * d_t_half]() mutable {
-                      double current = i;
-                      i += d_t;
-                      return current;
-                  });
-
-    auto case_ = this->get_case();
-
-    for (uint i = 0; i < this->_n_streamtubes / 2; i++) {
-        uint i_down = this->_n_streamtubes - 1 - i;
-
-        double theta_up = theta[i];
-        double theta_down = theta[i_down];
-        auto [beta_up, beta_down, a_up, a_down] =
-            solve_fn(case_, theta_up, theta_down);
-
-        beta[i] = beta_up;
-        beta[i_down] = beta_down;
-        a[i] = a_up;
-        a[i_down] = a_down;
-        a_0[i_down] = a_up;
-    }
-
-    // the solution is 2 PI periodic, so we can extrapolate a bit
-    theta.insert(theta.begin(), theta.back() - 2 * PI);
-    theta.push_back(theta[1] + 2 * PI);
-    beta.insert(beta.begin(), beta.back());
-    beta.push_back(beta[1]);
-    a.insert(a.begin(), a.back());
-    a.push_back(a[1]);
-    a_0.insert(a_0.begin(), a_0.back());
-    a_0.push_back(a_0[1]);
-
-    return VAWTSolution(case_, this->_n_streamtubes, theta, beta, a, a_0,
-                        this->_epsilon);
-}
-
-VAWTCase VAWTSolver::get_case() {
-    return VAWTCase{this->_re, this->_tsr, this->_solidity, this->aerofoil};
+    return this->solve<std::function<double(double)>>(beta);
+}
+
+void VAWTSolver::solve_into(double beta, Workspace& workspace,
+                            VAWTSolution& solution) {
+    this->solve_into(ConstantPitch(beta), workspace, solution);
+}
+
+void VAWTSolver::solve_into(const std::function<double(double)>& beta,
+                            Workspace& workspace, VAWTSolution& solution) {
+    this->solve_into<std::function<double(double)>>(beta, workspace,
+                                                    solution);
+}
+
+VAWTSolver::Workspace& VAWTSolver::thread_workspace() {
+    thread_local Workspace workspace;
+    return workspace;
+}
+
+std::vector<VAWTSolution>
+VAWTSolver::solve_batch(std::span<const OperatingPoint> points, double beta) {
+    return this->solve_batch(points, ConstantPitch(beta));
+}
+
+void VAWTSolver::prepare_workspace(Workspace& workspace) {
+    size_t n = this->_n_streamtubes;
+    if (!workspace.geometry || workspace.geometry->n_streamtubes() != n) {
+        workspace.geometry = RotorGeometry::get(n);
+    }
+    workspace.beta.resize(n);
+    workspace.results.resize(n);
+}
+
+void VAWTSolver::solve_prepared(Workspace& workspace,
+                                VAWTSolution& solution) {
+    size_t n = this->_n_streamtubes;
+    size_t half = n / 2;
+    this->prepare_case(workspace.case_);
+    VAWTSolution* prior = this->prior_for(workspace.case_);
+    if (this->_lockstep) {
+        if (this->_root_finder != RootFinder::Bisection) {
+            throw "lockstep solves only support bisection";
+        }
+        workspace.a_0.resize(n);
+        workspace.guess.resize(n);
+    } else {
+        // with an odd number of streamtubes the one in the middle is not
+        // solved
+        std::fill(workspace.results.begin(), workspace.results.end(),
+                  TubeResult{});
+    }
+
+    if (this->runs_parallel(prior)) {
+        size_t n_chunks = (half + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+        ThreadPool::shared().parallel_for(n_chunks, [&](size_t k) {
+            size_t lo = k * PARALLEL_CHUNK;
+            size_t hi = std::min(half, lo + PARALLEL_CHUNK);
+            if (this->_lockstep) {
+                StreamTubeBatch batch;
+                this->solve_lockstep(prior, workspace, batch, lo, hi);
+            } else {
+                this->solve_streamtubes(prior, workspace, lo, hi);
+            }
+        });
+    } else if (this->_lockstep) {
+        if (!workspace.batch) {
+            workspace.batch = std::make_unique<StreamTubeBatch>();
+        }
+        this->solve_lockstep(prior, workspace, *workspace.batch, 0, half);
+    } else {
+        this->solve_streamtubes(prior, workspace, 0, half);
+    }
+    this->finish(workspace, solution);
+    if (this->_continuation) {
+        if (this->prior && this->prior.use_count() == 1) {
+            this->prior->assign(solution);
+        } else {
+            this->prior = std::make_shared<VAWTSolution>(solution);
+        }
+        this->prior_explicit = false;
+    }
+}
+
+std::vector<VAWTSolution>
+VAWTSolver::solve_batch_prepared(std::span<const OperatingPoint> points,
+                                 Workspace& workspace) {
+    if (this->_root_finder != RootFinder::Bisection) {
+        throw "batch solves only support bisection";
+    }
+    const RotorGeometry& geometry = *workspace.geometry;
+    size_t n = geometry.n_streamtubes();
+    size_t half = n / 2;
+    size_t m = points.size() * half;
+    std::vector<VAWTCase> cases(points.size());
+    for (size_t k = 0; k < points.size(); k++) {
+        cases[k].aerofoil = this->aerofoil;
+        cases[k].tsr = points[k].tsr;
+        cases[k].re = points[k].re;
+        cases[k].solidity = this->_solidity;
+    }
+
+    // the lanes of both halves are in the same order, so the downwind lane
+    // of a partner takes the upwind result of the same lane as `a_0`
+    std::vector<size_t> upwind(half), downwind(half);
+    for (size_t i = 0; i < half; i++) {
+        upwind[i] = i;
+        downwind[i] = geometry.partner(i);
+    }
+    std::vector<double> a_0(m, 0.0), guess(m, NAN);
+    std::vector<TubeResult> results_up(m), results_down(m);
+    StreamTubeBatch batch;
+    batch.reset(cases, geometry, upwind, workspace.beta, a_0);
+    batch.solve_a(this->_epsilon, this->_residual, guess, results_up);
+    for (size_t i = 0; i < m; i++) {
+        a_0[i] = results_up[i].a;
+    }
+    batch.reset(cases, geometry, downwind, workspace.beta, a_0);
+    batch.solve_a(this->_epsilon, this->_residual, guess, results_down);
+
+    std::vector<VAWTSolution> solutions(points.size());
+    for (size_t k = 0; k < points.size(); k++) {
+        for (size_t i = 0; i < half; i++) {
+            workspace.results[upwind[i]] = results_up[k * half + i];
+            workspace.results[downwind[i]] = results_down[k * half + i];
+        }
+        workspace.case_ = cases[k];
+        this->finish(workspace, solutions[k]);
+    }
+    return solutions;
+}
+
+bool VAWTSolver::runs_parallel(const VAWTSolution* prior) const {
+    // guesses from the neighbouring streamtube chain the whole solve
+    bool chained = this->_continuation && !prior && !this->_lockstep;
+    return this->_parallel &&
+           this->_n_streamtubes >= PARALLEL_MIN_STREAMTUBES && !chained;
+}
+
+VAWTSolver& VAWTSolver::warm_start(const VAWTSolution& prior) {
+    this->prior = std::make_shared<VAWTSolution>(prior);
+    this->prior_explicit = true;
+    return *this;
+}
+
+VAWTSolution* VAWTSolver::prior_for(const VAWTCase& case_) {
+    if (!this->prior || this->prior->case_.aerofoil != case_.aerofoil) {
+        return nullptr;
+    }
+    if (this->prior_explicit) {
+        return this->prior.get();
+    }
+    auto near = [](double value, double reference) {
+        return std::abs(value - reference) <=
+               MAX_CONTINUATION_STEP * std::abs(reference);
+    };
+    const VAWTCase& prior = this->prior->case_;
+    if (near(case_.tsr, prior.tsr) && near(case_.re, prior.re) &&
+        near(case_.solidity, prior.solidity)) {
+        return this->prior.get();
+    }
+    return nullptr;
+}
+
+void VAWTSolver::check_resolve(std::span<const size_t> tubes,
+                               const VAWTSolution& solution) {
+    const VAWTCase& case_ = solution.case_;
+    if (solution.n_streamtubes != this->_n_streamtubes ||
+        solution._theta.size() != this->_n_streamtubes + 2 ||
+        case_.aerofoil != this->aerofoil || case_.tsr != this->_tsr ||
+        case_.re != this->_re || case_.solidity != this->_solidity) {
+        throw "solution was not solved with the case of this solver";
+    }
+    for (size_t i : tubes) {
+        if (i >= this->_n_streamtubes) {
+            throw "streamtube index out of range";
+        }
+    }
+}
+
+void VAWTSolver::resolve_prepared(std::span<const size_t> tubes,
+                                  VAWTSolution& solution) {
+    size_t n = this->_n_streamtubes;
+    size_t half = n / 2;
+    // an upwind streamtube changes the upstream induction factor of its
+    // downwind partner, which is re-solved after it
+    auto geometry = RotorGeometry::get(n);
+    std::vector<size_t> upwind, downwind;
+    for (size_t i : tubes) {
+        if (i < half) {
+            upwind.push_back(i);
+            downwind.push_back(geometry->partner(i));
+        } else {
+            downwind.push_back(i);
+        }
+    }
+    for (std::vector<size_t>* v : {&upwind, &downwind}) {
+        std::sort(v->begin(), v->end());
+        v->erase(std::unique(v->begin(), v->end()), v->end());
+    }
+
+    VAWTCase case_;
+    this->prepare_case(case_);
+    auto solve_tube = [&](size_t i, double a_0) {
+        double guess = solution.guess(geometry->theta()[i]);
+        TubeResult result =
+            StreamTube(*geometry, i, solution._beta[i + 1], a_0)
+                .solve_a(case_, this->_root_finder, this->_epsilon,
+                         this->_residual, guess);
+        solution._a[i + 1] = result.a;
+        solution._a_0[i + 1] = a_0;
+        solution._iterations[i] = result.iterations;
+        solution._converged[i] = result.converged;
+        solution._bracketed[i] = result.bracketed;
+    };
+    for (size_t i : upwind) {
+        solve_tube(i, 0.0);
+    }
+    for (size_t i : downwind) {
+        solve_tube(i, solution._a[n - i]);
+    }
+
+    // the padding entries repeat the first and the last streamtube
+    for (std::vector<double>* v :
+         {&solution._beta, &solution._a, &solution._a_0}) {
+        (*v)[0] = (*v)[n];
+        (*v)[n + 1] = (*v)[1];
+    }
+    for (std::vector<size_t>* v : {&upwind, &downwind}) {
+        for (size_t i : *v) {
+            solution.update_torque(i + 1);
+            if (i == 0) {
+                solution.update_torque(n + 1);
+            }
+            if (i == n - 1) {
+                solution.update_torque(0);
+            }
+        }
+    }
+}
+
+std::vector<size_t> VAWTSolver::streamtubes_between(double theta_lo,
+                                                    double theta_hi) {
+    theta_lo -= 2 * PI * std::floor(theta_lo / (2 * PI));
+    theta_hi -= 2 * PI * std::floor(theta_hi / (2 * PI));
+    const std::vector<double>& theta =
+        RotorGeometry::get(this->_n_streamtubes)->theta();
+    std::vector<size_t> tubes;
+    for (size_t i = 0; i < theta.size(); i++) {
+        bool inside = (theta_lo <= theta_hi)
+                          ? theta_lo <= theta[i] && theta[i] <= theta_hi
+                          : theta_lo <= theta[i] || theta[i] <= theta_hi;
+        if (inside) {
+            tubes.push_back(i);
+        }
+    }
+    return tubes;
+}
+
+void VAWTSolver::solve_streamtubes(VAWTSolution* prior, Workspace& workspace,
+                                   size_t lo, size_t hi) {
+    const VAWTCase& case_ = workspace.case_;
+    const RotorGeometry& geometry = *workspace.geometry;
+    const std::vector<double>& beta = workspace.beta;
+    std::vector<TubeResult>& results = workspace.results;
+    for (size_t i = lo; i < hi; i++) {
+        size_t i_down = geometry.partner(i);
+
+        double guess_up = NAN;
+        double guess_down = NAN;
+        if (prior) {
+            guess_up = prior->guess(geometry.theta()[i]);
+            guess_down = prior->guess(geometry.theta()[i_down]);
+        } else if (this->_continuation && i > 0) {
+            // continue from the neighbouring streamtubes
+            const TubeResult& left = results[i - 1];
+            const TubeResult& right = results[i_down + 1];
+            guess_up = left.bracketed ? left.a : NAN;
+            guess_down = right.bracketed ? right.a : NAN;
+        }
+        results[i] = StreamTube(geometry, i, beta[i], 0.0)
+                         .solve_a(case_, this->_root_finder, this->_epsilon,
+                                  this->_residual, guess_up);
+        results[i_down] = StreamTube(geometry, i_down, beta[i_down],
+                                     results[i].a)
+                              .solve_a(case_, this->_root_finder,
+                                       this->_epsilon, this->_residual,
+                                       guess_down);
+    }
+}
+
+void VAWTSolver::solve_lockstep(VAWTSolution* prior, Workspace& workspace,
+                                StreamTubeBatch& batch, size_t lo,
+                                size_t hi) {
+    const RotorGeometry& geometry = *workspace.geometry;
+    size_t n = geometry.n_streamtubes();
+    size_t half = n / 2;
+    size_t down_lo = (hi == half) ? half : n - hi;
+    size_t down_hi = n - lo;
+    auto prepare = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            workspace.guess[i] =
+                prior ? prior->guess(geometry.theta()[i]) : NAN;
+            workspace.a_0[i] = 0.0;
+        }
+    };
+    prepare(lo, hi);
+    prepare(down_lo, down_hi);
+
+    // the upwind chunk first, the downwind tubes need its induction factors
+    std::span<const double> beta(workspace.beta), a_0(workspace.a_0),
+        guess(workspace.guess);
+    std::span<TubeResult> results(workspace.results);
+    batch.reset(workspace.case_, geometry, lo, beta.subspan(lo, hi - lo),
+                a_0.subspan(lo, hi - lo));
+    batch.solve_a(this->_epsilon, this->_residual, guess.subspan(lo, hi - lo),
+                  results.subspan(lo, hi - lo));
+    for (size_t i = lo; i < hi; i++) {
+        workspace.a_0[geometry.partner(i)] = results[i].a;
+    }
+    size_t m = down_hi - down_lo;
+    batch.reset(workspace.case_, geometry, down_lo, beta.subspan(down_lo, m),
+                a_0.subspan(down_lo, m));
+    batch.solve_a(this->_epsilon, this->_residual, guess.subspan(down_lo, m),
+                  results.subspan(down_lo, m));
+}
+
+void VAWTSolver::prepare_case(VAWTCase& case_) {
+    case_.re = this->_re;
+    case_.tsr = this->_tsr;
+    case_.solidity = this->_solidity;
+    if (case_.aerofoil != this->aerofoil) {
+        case_.aerofoil = this->aerofoil;
+    }
+    case_.polar = nullptr;
+    if (this->_polar_view) {
+        double re_min =
+            std::max(this->_tsr - 1.0, 0.5 * this->_tsr) * this->_re;
+        double re_max = (this->_tsr + 1.0) * this->_re;
+        if (!this->view ||
+            !this->view->covers(this->aerofoil.get(), re_min, re_max)) {
+            // a little wider, so neighbouring cases of a sweep can reuse it
+            this->view = std::make_shared<const PolarView>(PolarView::slice(
+                *this->aerofoil, 0.9 * re_min, 1.1 * re_max));
+        }
+        if (this->view->sliced()) {
+            case_.polar = this->view.get();
+        }
+    }
+}
+
+void VAWTSolver::finish(const Workspace& workspace, VAWTSolution& solution) {
+    const std::vector<TubeResult>& results = workspace.results;
+    size_t n = results.size();
+    assign_case(solution.case_, workspace.case_);
+    // the solution may outlive the view
+    solution.case_.polar = nullptr;
+    solution.n_streamtubes = this->_n_streamtubes;
+    solution._epsilon = this->_epsilon;
+    solution._torque.clear();
+
+    // the solution is 2 PI periodic, so we can extrapolate a bit: one padding
+    // entry on each end
+    std::vector<double>& theta = solution._theta;
+    std::vector<double>& beta = solution._beta;
+    std::vector<double>& a = solution._a;
+    std::vector<double>& a_0 = solution._a_0;
+    for (std::vector<double>* v : {&theta, &beta, &a, &a_0}) {
+        v->resize(n + 2);
+    }
+    solution._iterations.resize(n);
+    solution._converged.resize(n);
+    solution._bracketed.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        theta[i + 1] = workspace.geometry->theta()[i];
+        beta[i + 1] = workspace.beta[i];
+        a[i + 1] = results[i].a;
+        a_0[i + 1] = 0.0;
+        solution._iterations[i] = results[i].iterations;
+        solution._converged[i] = results[i].converged;
+        solution._bracketed[i] = results[i].bracketed;
+    }
+    for (size_t i = 0; i < n / 2; i++) {
+        a_0[n - i] = a[i + 1];
+    }
+    for (std::vector<double>* v : {&theta, &beta, &a, &a_0}) {
+        (*v)[0] = (*v)[n];
+        (*v)[n + 1] = (*v)[1];
+    }
+    theta[0] -= 2 * PI;
+    theta[n + 1] += 2 * PI;
 }
 
 StreamTubeSolution VAWTSolution::solution(double theta) {
@@ -87,19 +444,62 @@ StreamTubeSolution VAWTSolution::solution(double theta) {
     return StreamTubeSolution(this->case_, tube, a);
 }
 
+double VAWTSolution::torque(size_t j) {
+    auto tube = StreamTube(this->_theta[j], this->_beta[j], this->_a_0[j]);
+    auto solution = StreamTubeSolution(this->case_, tube, this->_a[j]);
+    return solution.c_tan() * pow(solution.w(), 2);
+}
+
+void VAWTSolution::update_torque(size_t j) {
+    if (this->_torque.size() != this->_theta.size()) {
+        return;
+    }
+    double torque = this->torque(j);
+    this->_torque_sum += torque - this->_torque[j];
+    this->_torque[j] = torque;
+}
+
 double VAWTSolution::c_torque() {
-    double ct = 0.0;
-    for (int i = 0; i < this->_theta.size(); i++) {
-        auto theta = this->_theta[i];
-        auto beta = this->_beta[i];
-        auto a = this->_a[i];
-        auto a_0 = this->_a_0[i];
-        auto tube = StreamTube(theta, beta, a_0);
-        auto solution = StreamTubeSolution(this->case_, tube, a);
-        ct += solution.c_tan() * pow(solution.w(), 2);
-    }
-    return ct * this->case_.solidity / (double)this->n_streamtubes;
+    if (this->_torque.size() != this->_theta.size()) {
+        this->_torque.resize(this->_theta.size());
+        this->_torque_sum = 0.0;
+        for (size_t j = 0; j < this->_theta.size(); j++) {
+            this->_torque[j] = this->torque(j);
+            this->_torque_sum += this->_torque[j];
+        }
+    }
+    return this->_torque_sum * this->case_.solidity /
+           (double)this->n_streamtubes;
+}
+
+void VAWTSolution::assign(const VAWTSolution& other) {
+    assign_case(this->case_, other.case_);
+    this->n_streamtubes = other.n_streamtubes;
+    this->_theta = other._theta;
+    this->_beta = other._beta;
+    this->_a = other._a;
+    this->_a_0 = other._a_0;
+    this->_iterations = other._iterations;
+    this->_converged = other._converged;
+    this->_bracketed = other._bracketed;
+    this->_epsilon = other._epsilon;
+    this->_torque = other._torque;
+    this->_torque_sum = other._torque_sum;
 }
+
+double VAWTSolution::guess(double theta) {
+    size_t i = std::min((size_t)(theta / (2 * PI) * this->n_streamtubes),
+                        (size_t)this->n_streamtubes - 1);
+    if (!this->_bracketed[i]) {
+        return NAN;
+    }
+    // on the streamtube locations of this solution no interpolation is needed
+    if (this->_theta[i + 1] == theta) {
+        return this->_a[i + 1];
+    }
+    return this->a(theta);
+}
+
 double VAWTSolution::beta(double theta) {
     return _1D::LinearInterpolator<double>(this->_theta, this->_beta)(theta);
 }
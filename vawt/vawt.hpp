@@ -1,14 +1,86 @@
 #pragma once
 
 #include "aerofoil.hpp"
+#include "pitch.hpp"
+#include "polar_view.hpp"
+#include "rotor_geometry.hpp"
+#include <algorithm>
 
 namespace vawt {
 
 class VAWTSolution;
 struct VAWTCase;
 class StreamTubeSolution;
+class StreamTubeBatch;
+template <uint N> class FixedVAWTSolver;
+template <uint N> class FixedSolution;
+
+/**
+ * @brief root finding strategy for the induction factor of a streamtube
+ *
+ * All strategies start from the bracket `a = [-2, 2]`.
+ *
+ * - `Bisection` halves the bracket, one polar evaluation per iteration and
+ *   the iteration count grows with `log2(4 / epsilon)`
+ * - `Brent` combines inverse quadratic interpolation, secant and bisection
+ *   steps, superlinear on smooth residuals and never slower than bisection
+ * - `Illinois` is regula falsi with the Illinois modification, which keeps
+ *   both ends of the bracket moving
+ * - `Newton` takes Newton steps with the derivative from
+ *   `VAWTCase::cl_cd_grad` and falls back to bisection whenever a step leaves
+ *   the bracket. It pays off for smooth aerofoils with analytic derivatives,
+ *   otherwise each derivative costs 4 extra polar lookups.
+ */
+enum class RootFinder { Bisection, Brent, Illinois, Newton };
+
+/**
+ * @brief the induction factor of one streamtube and how it was found
+ */
+struct TubeResult {
+    /**
+     * @brief induction factor
+     */
+    double a;
+
+    /**
+     * @brief iterations of the root finder or the Strickland fallback
+     */
+    uint iterations;
+
+    /**
+     * @brief false when the iteration limit was reached before the tolerance
+     */
+    bool converged;
+
+    /**
+     * @brief false when the thrust error did not change its sign on the
+     * initial bracket and the Strickland fallback was used
+     */
+    bool bracketed;
+};
+
+/**
+ * @brief the tip speed ratio and reynolds number of one case of a
+ * `VAWTSolver::solve_batch`
+ */
+struct OperatingPoint {
+    /**
+     * @brief Tipspeed ratio of the turbine
+     */
+    double tsr;
+
+    /**
+     * @brief Reynolds number of the turbine
+     */
+    double re;
+};
 
 class VAWTSolver {
+    template <uint N> friend class FixedVAWTSolver;
+
+  public:
+    class Workspace;
+
   private:
     std::shared_ptr<Aerofoil> aerofoil;
     uint _n_streamtubes = 50;
@@ -16,23 +88,141 @@ class VAWTSolver {
     double _re = 60'000.0;
     double _solidity = 0.1;
     double _epsilon = 0.01;
+    double _residual = 0.0;
+    RootFinder _root_finder = RootFinder::Bisection;
+    bool _polar_view = false;
+    bool _continuation = false;
+    bool _lockstep = false;
+    bool _parallel = false;
+    std::shared_ptr<const PolarView> view;
+    std::shared_ptr<VAWTSolution> prior;
+    bool prior_explicit = false;
 
     /**
-     * @brief iterate over all streamtubes, applying `solve_fn`.
+     * @brief update `case_` to the case to solve, with the polar view set up
+     * if enabled
      *
-     * `solve_fn` is called for each pair of up and downstream streamtubes with:
-     * `Fn(case: VAWTCase, theta_up: double, theta_down: double) -> (beta_up:
-     * double, beta_down: double, a_up: double, a_down: double)`
-     * @param solve_fn
-     * @return VAWTSolution
+     * The aerofoil pointer is only assigned when it changed, so a reused case
+     * does not touch its reference count.
+     *
+     * @param case_
+     */
+    void prepare_case(VAWTCase& case_);
+
+    /**
+     * @brief solve the pairs of up and downstream streamtubes `[lo, hi)` in
+     * turn
+     *
+     * @param prior - solution to take initial guesses from, may be `nullptr`
+     * @param workspace
+     * @param lo - first upwind streamtube
+     * @param hi - one past the last upwind streamtube
+     */
+    void solve_streamtubes(VAWTSolution* prior, Workspace& workspace,
+                           size_t lo, size_t hi);
+
+    /**
+     * @brief solve the upwind streamtubes `[lo, hi)` and then their downwind
+     * partners in lockstep, see `lockstep`
+     *
+     * The streamtube in the middle of an odd count is solved with the chunk
+     * that ends at the middle.
+     *
+     * @param prior - solution to take initial guesses from, may be `nullptr`
+     * @param workspace
+     * @param batch
+     * @param lo - first upwind streamtube
+     * @param hi - one past the last upwind streamtube
+     */
+    void solve_lockstep(VAWTSolution* prior, Workspace& workspace,
+                        StreamTubeBatch& batch, size_t lo, size_t hi);
+
+    /**
+     * @brief size the buffers of `workspace` for this solver and set the
+     * streamtube locations
+     *
+     * @param workspace
+     */
+    void prepare_workspace(Workspace& workspace);
+
+    /**
+     * @brief solve with the pitch angles already in `workspace`
+     *
+     * @param workspace
+     * @param solution - output
+     */
+    void solve_prepared(Workspace& workspace, VAWTSolution& solution);
+
+    /**
+     * @brief solve `points` with the pitch angles already in `workspace`, see
+     * `solve_batch`
+     *
+     * @param points
+     * @param workspace
+     * @return std::vector<VAWTSolution>
+     */
+    std::vector<VAWTSolution>
+    solve_batch_prepared(std::span<const OperatingPoint> points,
+                         Workspace& workspace);
+
+    /**
+     * @brief will this solve be split into tasks, see `parallel`
+     *
+     * @param prior
+     * @return true
+     * @return false
+     */
+    bool runs_parallel(const VAWTSolution* prior) const;
+
+    /**
+     * @brief collect the results of all streamtubes into `solution`
+     *
+     * @param workspace
+     * @param solution
+     */
+    void finish(const Workspace& workspace, VAWTSolution& solution);
+
+    /**
+     * @brief the prior solution to take initial guesses from for `case_`,
+     * `nullptr` if there is none or it is too far from `case_`
+     *
+     * @param case_
+     * @return VAWTSolution*
+     */
+    VAWTSolution* prior_for(const VAWTCase& case_);
+
+    /**
+     * @brief throw unless `solution` was solved with the case and number of
+     * streamtubes of this solver and all of `tubes` are streamtube indices
+     *
+     * @param tubes
+     * @param solution
      */
-    VAWTSolution
-    map_streamtubes(std::function<std::tuple<double, double, double, double>(
-                        VAWTCase, double, double)>
-                        solve_fn);
-    VAWTCase get_case();
+    void check_resolve(std::span<const size_t> tubes,
+                       const VAWTSolution& solution);
+
+    /**
+     * @brief re-solve `tubes` and their downwind partners in `solution`,
+     * whose pitch angles are already updated
+     *
+     * @param tubes
+     * @param solution
+     */
+    void resolve_prepared(std::span<const size_t> tubes,
+                          VAWTSolution& solution);
 
   public:
+    /**
+     * @brief smallest number of streamtubes for which `parallel` splits a
+     * solve, smaller solves are not worth the scheduling
+     */
+    static const uint PARALLEL_MIN_STREAMTUBES = 512;
+
+    /**
+     * @brief number of upwind streamtubes per task of a parallel solve
+     */
+    static const uint PARALLEL_CHUNK = 64;
+
     /**
      * @brief create a new Solver with the following default values:
      *
@@ -97,13 +287,294 @@ class VAWTSolver {
         return *this;
     }
 
+    /**
+     * @brief update the solution accuracy for a
+     *
+     * The root finder stops once the bracket around the induction factor is
+     * narrower than `epsilon`, or once the residual criterion (see
+     * `residual`) is met.
+     *
+     * @param epsilon
+     * @return VAWTSolver&
+     */
     VAWTSolver& epsilon(double epsilon) {
         this->_epsilon = epsilon;
         return *this;
     }
 
+    /**
+     * @brief also stop the root finder once the thrust error is at most
+     * `residual`
+     *
+     * With `residual = 0` (the default) the root finder stops on the bracket
+     * width, or early when it hits a point where the thrust error is exactly
+     * 0.
+     *
+     * @param residual
+     * @return VAWTSolver&
+     */
+    VAWTSolver& residual(double residual) {
+        this->_residual = residual;
+        return *this;
+    }
+
+    /**
+     * @brief select the root finding strategy for the induction factors
+     *
+     * @param method
+     * @return VAWTSolver&
+     */
+    VAWTSolver& root_finder(RootFinder method) {
+        this->_root_finder = method;
+        return *this;
+    }
+
+    /**
+     * @brief solve against a `PolarView` of the aerofoil
+     *
+     * At the start of each solve the polar is sliced to the reynolds band
+     * `re * [tsr - 1, tsr + 1]` the case reaches, so the lookups in the inner
+     * loop work on a table that stays in the L1 cache. The view is kept and
+     * reused by later solves as long as their band lies within it. The
+     * results are the same as without a view. Only aerofoils with a uniform
+     * grid are sliced, smooth ones and those without a uniform grid are
+     * solved against the aerofoil itself.
+     *
+     * @param yes
+     * @return VAWTSolver&
+     */
+    VAWTSolver& polar_view(bool yes) {
+        this->_polar_view = yes;
+        return *this;
+    }
+
+    /**
+     * @brief take the initial guesses for the induction factors from a prior
+     * solution
+     *
+     * Each streamtube is bracketed tightly around the induction factor of
+     * `prior` at the same location, the bracket is only widened as far as
+     * necessary. Streamtubes for which `prior` used the Strickland fallback
+     * are solved from scratch. The guess is used by all following solves
+     * until it is replaced.
+     *
+     * @param prior
+     * @return VAWTSolver&
+     */
+    VAWTSolver& warm_start(const VAWTSolution& prior);
+
+    /**
+     * @brief reuse solutions as initial guesses automatically
+     *
+     * Each solve keeps its solution as the warm start (see `warm_start`) for
+     * the next one, as long as tsr, re and solidity of the next case differ
+     * by at most 10%. This suits sweeps over closely spaced cases. Without a
+     * prior solution the streamtubes take the induction factor of their
+     * already solved neighbour as initial guess.
+     *
+     * The results agree with a cold solve within `epsilon`. Where the thrust
+     * error has several roots the warm start follows the one of the guess.
+     *
+     * @param yes
+     * @return VAWTSolver&
+     */
+    VAWTSolver& continuation(bool yes) {
+        this->_continuation = yes;
+        return *this;
+    }
+
+    /**
+     * @brief solve the streamtubes in lockstep
+     *
+     * The upwind streamtubes do not depend on each other, so all of them
+     * bisect their brackets together: each step evaluates the thrust error
+     * of every unfinished tube in one pass, with a single batched polar
+     * lookup. Then the downwind streamtubes are solved the same way. The
+     * results are bit for bit the same as solving one tube after the other.
+     *
+     * Requires `RootFinder::Bisection`. Initial guesses from a prior solution
+     * are used, guesses from neighbouring streamtubes (see `continuation`)
+     * are not.
+     *
+     * @param yes
+     * @return VAWTSolver&
+     */
+    VAWTSolver& lockstep(bool yes) {
+        this->_lockstep = yes;
+        return *this;
+    }
+
+    /**
+     * @brief split each solve into tasks on `ThreadPool::shared()`
+     *
+     * The upwind streamtubes are split into chunks of `PARALLEL_CHUNK`. Each
+     * task solves one upwind chunk and then the downwind streamtubes paired
+     * with it, so a downwind chunk starts as soon as its upwind chunk is
+     * done, independent of the other chunks. Every streamtube is solved with
+     * the same inputs as in a serial solve, the results are identical.
+     *
+     * Solves with fewer than `PARALLEL_MIN_STREAMTUBES` streamtubes stay
+     * serial. So do `continuation` solves without a prior solution, where each
+     * streamtube starts from its neighbour's result.
+     *
+     * @param yes
+     * @return VAWTSolver&
+     */
+    VAWTSolver& parallel(bool yes) {
+        this->_parallel = yes;
+        return *this;
+    }
+
     VAWTSolution solve(double beta);
+
+    /**
+     * @brief solve for the pitch schedule `beta`
+     *
+     * The pitch is evaluated once for all streamtubes before they are solved,
+     * in a single call for a `BatchPitch`. Any callable is called directly,
+     * without type erasure.
+     *
+     * @tparam Pitch - see `PitchSchedule`, for example `ConstantPitch`,
+     * `FourierPitch`, `TabulatedPitch` or a lambda
+     * @param beta - pitch angle as a function of theta
+     * @return VAWTSolution
+     */
+    template <PitchSchedule Pitch> VAWTSolution solve(const Pitch& beta);
+
+    /**
+     * @brief solve for a type erased pitch schedule, an overload with a
+     * stable signature for use across library boundaries
+     *
+     * @param beta
+     * @return VAWTSolution
+     */
     VAWTSolution solve(std::function<double(double)> beta);
+
+    /**
+     * @brief solve into an existing solution
+     *
+     * `workspace` holds the buffers of the solve and `solution` is
+     * overwritten in place. Once both have been used for a solve with the
+     * same number of streamtubes, later solves neither allocate memory nor
+     * copy the aerofoil pointer. The results are the same as from `solve`.
+     *
+     * @tparam Pitch - see `solve`
+     * @param beta - pitch angle as a function of theta
+     * @param workspace
+     * @param solution - output
+     */
+    template <PitchSchedule Pitch>
+    void solve_into(const Pitch& beta, Workspace& workspace,
+                    VAWTSolution& solution);
+    void solve_into(const std::function<double(double)>& beta,
+                    Workspace& workspace, VAWTSolution& solution);
+    void solve_into(double beta, Workspace& workspace,
+                    VAWTSolution& solution);
+
+    /**
+     * @brief the workspace of the calling thread
+     *
+     * For solves spread over a thread pool: each thread reuses the buffers
+     * for all the solves it makes. A pitch schedule must not solve with it
+     * while it is in use.
+     *
+     * @return Workspace&
+     */
+    static Workspace& thread_workspace();
+
+    /**
+     * @brief solve a copy of this solver at `tsr` and `re` into `solution`,
+     * with the workspace of the calling thread
+     *
+     * @tparam Pitch - see `solve`
+     * @param tsr
+     * @param re
+     * @param beta - pitch angle as a function of theta
+     * @param solution - output
+     */
+    template <PitchSchedule Pitch>
+    void solve_at(double tsr, double re, const Pitch& beta,
+                  VAWTSolution& solution) const;
+
+    /**
+     * @brief solve the pitch schedule `beta` at each of `points`, with the
+     * solidity and all other settings of this solver
+     *
+     * The cases are solved together, with one lane per streamtube of each
+     * case: all upwind streamtubes of all cases take their `bisection` steps
+     * in lockstep with a single batched polar lookup per step, then all
+     * downwind streamtubes. A batch of cases keeps the lanes filled where a
+     * single solve with few streamtubes has too few of them.
+     *
+     * The solutions are the same as from `solve` with `tsr` and `re` set to
+     * each point, without a polar view and without warm starts. The warm
+     * start of this solver is neither used nor changed.
+     *
+     * @tparam Pitch - see `solve`
+     * @param points - tip speed ratio and reynolds number of each case
+     * @param beta - pitch angle as a function of theta
+     * @return std::vector<VAWTSolution> - one per point
+     */
+    template <PitchSchedule Pitch>
+    std::vector<VAWTSolution>
+    solve_batch(std::span<const OperatingPoint> points, const Pitch& beta);
+    std::vector<VAWTSolution>
+    solve_batch(std::span<const OperatingPoint> points, double beta);
+
+    /**
+     * @brief indices of the streamtubes located in `[theta_lo, theta_hi]`,
+     * the range wraps around `2 PI` when `theta_lo > theta_hi`
+     *
+     * @param theta_lo
+     * @param theta_hi
+     * @return std::vector<size_t>
+     */
+    std::vector<size_t> streamtubes_between(double theta_lo, double theta_hi);
+
+    /**
+     * @brief update `solution` to the pitch schedule `beta`, which only
+     * changed at the streamtubes `tubes`
+     *
+     * Only the listed streamtubes are re-solved, together with the downwind
+     * partners of the upwind ones, whose upstream induction factor changes
+     * with them. Each starts from its induction factor in `solution`, so the
+     * re-solved streamtubes match a full solve warm started from `solution`
+     * (see `warm_start`). All other streamtubes keep their results. The number
+     * of streamtubes is always even (see `n_streamtubes`), so no streamtube
+     * is its own downwind partner.
+     *
+     * Once `c_torque` was called on `solution` it is updated by the change
+     * of the re-solved streamtubes instead of summing over all of them.
+     *
+     * The warm start of this solver is not changed.
+     *
+     * @tparam Pitch - see `solve`
+     * @param beta - the new pitch angle as a function of theta
+     * @param tubes - indices of the changed streamtubes, in the order of
+     * increasing theta
+     * @param solution - a solution of this solver, updated in place
+     */
+    template <PitchSchedule Pitch>
+    void resolve(const Pitch& beta, std::span<const size_t> tubes,
+                 VAWTSolution& solution);
+
+    /**
+     * @brief update `solution` to the pitch schedule `beta`, which only
+     * changed for theta in `[theta_lo, theta_hi]`, see above
+     *
+     * @tparam Pitch - see `solve`
+     * @param beta - the new pitch angle as a function of theta
+     * @param theta_lo
+     * @param theta_hi - wraps around `2 PI` when smaller than `theta_lo`
+     * @param solution - a solution of this solver, updated in place
+     */
+    template <PitchSchedule Pitch>
+    void resolve(const Pitch& beta, double theta_lo, double theta_hi,
+                 VAWTSolution& solution) {
+        std::vector<size_t> tubes =
+            this->streamtubes_between(theta_lo, theta_hi);
+        this->resolve(beta, tubes, solution);
+    }
 };
 
 /**
@@ -130,30 +601,184 @@ struct VAWTCase {
      * @brief Aerofoil
      */
     std::shared_ptr<Aerofoil> aerofoil;
+
+    /**
+     * @brief optional view on the aerofoil polar for the reynolds band of
+     * this case, only set while the case is being solved
+     */
+    const PolarView* polar = nullptr;
+
+    /**
+     * @brief lift and drag coefficients, through the polar view if one is set
+     *
+     * @param alpha
+     * @param re
+     * @return ClCd
+     */
+    ClCd cl_cd(double alpha, double re) const {
+        if (this->polar) {
+            return this->polar->cl_cd(alpha, re);
+        }
+        return this->aerofoil->cl_cd(alpha, re);
+    }
+
+    /**
+     * @brief lift and drag coefficients with the symmetry of the aerofoil
+     * known at compile time, see `Aerofoil::cl_cd<Symmetry>`
+     *
+     * @tparam Symmetry
+     * @param alpha
+     * @param re
+     * @return ClCd
+     */
+    template <class Symmetry> ClCd cl_cd(double alpha, double re) const {
+        if (this->polar) {
+            return this->polar->cl_cd<Symmetry>(alpha, re);
+        }
+        return this->aerofoil->cl_cd<Symmetry>(alpha, re);
+    }
+
+    /**
+     * @brief lift and drag coefficients and their derivatives, of the same
+     * function `cl_cd<Symmetry>` evaluates
+     *
+     * Through a polar view the derivatives are finite differences of the
+     * view's lookups, the view only holds piecewise linear tables.
+     *
+     * @tparam Symmetry
+     * @param alpha
+     * @param re
+     * @return ClCdGrad
+     */
+    template <class Symmetry>
+    ClCdGrad cl_cd_grad(double alpha, double re) const {
+        if (this->polar) {
+            return ClCdGrad::central(
+                [this](double alpha, double re) {
+                    return this->polar->cl_cd<Symmetry>(alpha, re);
+                },
+                alpha, re);
+        }
+        return this->aerofoil->cl_cd_grad<Symmetry>(alpha, re);
+    }
+
+    /**
+     * @brief lift and drag coefficients for many points at once, through the
+     * polar view if one is set
+     *
+     * Gives the same results as calling `cl_cd` for each point.
+     *
+     * @param alpha
+     * @param re
+     * @param cl - output
+     * @param cd - output
+     */
+    void cl_cd_batch(std::span<const double> alpha, std::span<const double> re,
+                     std::span<double> cl, std::span<double> cd) const {
+        if (this->polar) {
+            for (size_t i = 0; i < alpha.size(); i++) {
+                ClCd coeffs = this->polar->cl_cd(alpha[i], re[i]);
+                cl[i] = coeffs.cl();
+                cd[i] = coeffs.cd();
+            }
+            return;
+        }
+        this->aerofoil->cl_cd_batch(alpha, re, cl, cd);
+    }
+};
+
+/**
+ * @brief the buffers of a solve, see `VAWTSolver::solve_into`
+ *
+ * A workspace may be reused with any solver, but only by one solve at a time.
+ */
+class VAWTSolver::Workspace {
+    friend VAWTSolver;
+
+  private:
+    VAWTCase case_{};
+    std::shared_ptr<const RotorGeometry> geometry;
+    std::vector<double> beta;
+    std::vector<double> a_0;
+    std::vector<double> guess;
+    std::vector<TubeResult> results;
+    std::unique_ptr<StreamTubeBatch> batch;
+
+  public:
+    Workspace();
+    ~Workspace();
+    Workspace(Workspace&&) noexcept;
+    Workspace& operator=(Workspace&&) noexcept;
 };
 
 class VAWTSolution {
     friend VAWTSolver;
 
   private:
-    VAWTCase case_;
-    uint n_streamtubes;
+    VAWTCase case_{};
+    uint n_streamtubes = 0;
     std::vector<double> _theta;
     std::vector<double> _beta;
     std::vector<double> _a;
     std::vector<double> _a_0;
-    double _epsilon;
+    std::vector<uint> _iterations;
+    std::vector<bool> _converged;
+    std::vector<bool> _bracketed;
+    double _epsilon = 0.0;
+
+    /**
+     * @brief torque of each entry of `_theta`, empty until `c_torque` is
+     * called
+     */
+    std::vector<double> _torque;
+    double _torque_sum = 0.0;
     StreamTubeSolution solution(double theta);
-    VAWTSolution(VAWTCase case_, uint n_streamtubes, std::vector<double> theta,
-                 std::vector<double> beta, std::vector<double> a,
-                 std::vector<double> a_0, double epsilon)
-        : case_(case_), _theta(theta), _beta(beta), _a(a), _a_0(a_0),
-          _epsilon(epsilon){};
+
+    /**
+     * @brief torque of the entry `j` of `_theta`, not yet scaled by
+     * solidity and number of streamtubes
+     *
+     * @param j
+     * @return double
+     */
+    double torque(size_t j);
+
+    /**
+     * @brief update the torque of the entry `j` of `_theta` and their sum,
+     * if `c_torque` was already called
+     *
+     * @param j
+     */
+    void update_torque(size_t j);
+
+    /**
+     * @brief copy `other` into this solution, reusing the buffers
+     *
+     * @param other
+     */
+    void assign(const VAWTSolution& other);
+
+    /**
+     * @brief initial guess for a at the location `theta` for a later solve,
+     * `NaN` where the Strickland fallback was used
+     *
+     * @param theta
+     * @return double
+     */
+    double guess(double theta);
 
   public:
+    /**
+     * @brief an empty solution, to be filled by `VAWTSolver::solve_into`
+     */
+    VAWTSolution() = default;
+
     /**
      * @brief Torque ceofficient of the turbine
      *
+     * The torque of each streamtube is kept, so that `VAWTSolver::resolve`
+     * only needs to update the re-solved ones.
+     *
      * @return double
      */
     double c_torque();
@@ -209,6 +834,35 @@ class VAWTSolution {
     double c_tan(double theta);
     double epsilon() { return this->_epsilon; }
 
+    /**
+     * @brief number of root finder iterations spent on each streamtube, in
+     * the order of increasing theta
+     *
+     * A streamtube whose thrust error has no sign change in the initial
+     * bracket counts the iterations of the Strickland fallback.
+     *
+     * @return const std::vector<uint>&
+     */
+    const std::vector<uint>& iterations() const { return this->_iterations; }
+
+    /**
+     * @brief for each streamtube, in the order of increasing theta, whether
+     * its induction factor converged within the iteration limit
+     *
+     * @return const std::vector<bool>&
+     */
+    const std::vector<bool>& converged() const { return this->_converged; }
+
+    /**
+     * @brief number of streamtubes that reached the iteration limit
+     *
+     * @return uint
+     */
+    uint n_unconverged() const {
+        return std::count(this->_converged.begin(), this->_converged.end(),
+                          false);
+    }
+
     /**
      * @brief the relative windspeed at the foil at location `theta`
      *
@@ -234,4 +888,52 @@ class VAWTSolution {
     double re(double theta);
 };
 
+template <PitchSchedule Pitch>
+VAWTSolution VAWTSolver::solve(const Pitch& beta) {
+    Workspace workspace;
+    VAWTSolution solution;
+    this->solve_into(beta, workspace, solution);
+    return solution;
+}
+
+template <PitchSchedule Pitch>
+void VAWTSolver::solve_into(const Pitch& beta, Workspace& workspace,
+                            VAWTSolution& solution) {
+    this->prepare_workspace(workspace);
+    pitch_angles(beta, workspace.geometry->theta(), workspace.beta);
+    this->solve_prepared(workspace, solution);
+}
+
+template <PitchSchedule Pitch>
+void VAWTSolver::solve_at(double tsr, double re, const Pitch& beta,
+                          VAWTSolution& solution) const {
+    VAWTSolver solver = *this;
+    solver.tsr(tsr).re(re).solve_into(beta, thread_workspace(), solution);
+}
+
+template <PitchSchedule Pitch>
+std::vector<VAWTSolution>
+VAWTSolver::solve_batch(std::span<const OperatingPoint> points,
+                        const Pitch& beta) {
+    Workspace workspace;
+    this->prepare_workspace(workspace);
+    pitch_angles(beta, workspace.geometry->theta(), workspace.beta);
+    return this->solve_batch_prepared(points, workspace);
+}
+
+template <PitchSchedule Pitch>
+void VAWTSolver::resolve(const Pitch& beta, std::span<const size_t> tubes,
+                         VAWTSolution& solution) {
+    this->check_resolve(tubes, solution);
+    size_t n = this->_n_streamtubes;
+    for (size_t i : tubes) {
+        solution._beta[i + 1] = beta(solution._theta[i + 1]);
+        if (i < n / 2) {
+            size_t i_down = n - 1 - i;
+            solution._beta[i_down + 1] = beta(solution._theta[i_down + 1]);
+        }
+    }
+    this->resolve_prepared(tubes, solution);
+}
+
 } // namespace vawt
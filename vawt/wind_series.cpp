@@ -0,0 +1,455 @@
+#include "wind_series.hpp"
+#include "polar_cache.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+namespace vawt {
+
+/**
+ * @brief a queue between two stages of the pipeline
+ *
+ * `push` blocks while the queue is full, `pop` while it is empty. After
+ * `close` nothing more is pushed and `pop` fails once the queue is drained.
+ */
+template <class T> class BoundedQueue {
+  private:
+    mutex _mutex;
+    condition_variable not_full, not_empty;
+    deque<T> items;
+    size_t capacity;
+    bool closed = false;
+
+  public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    /**
+     * @brief add an item, waits for space
+     *
+     * @param item
+     * @return false - the queue was closed, the item is dropped
+     */
+    bool push(T item) {
+        unique_lock lock(this->_mutex);
+        this->not_full.wait(lock, [&]() {
+            return this->closed || this->items.size() < this->capacity;
+        });
+        if (this->closed) {
+            return false;
+        }
+        this->items.push_back(std::move(item));
+        this->not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief take the oldest item, waits for one
+     *
+     * @param item - output
+     * @return false - the queue is closed and empty
+     */
+    bool pop(T& item) {
+        unique_lock lock(this->_mutex);
+        this->not_empty.wait(
+            lock, [&]() { return this->closed || !this->items.empty(); });
+        if (this->items.empty()) {
+            return false;
+        }
+        item = std::move(this->items.front());
+        this->items.pop_front();
+        this->not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard lock(this->_mutex);
+        this->closed = true;
+        this->not_full.notify_all();
+        this->not_empty.notify_all();
+    }
+};
+
+/**
+ * @brief a tsr and log(re) rounded to the solve grid
+ */
+struct GridKey {
+    int64_t tsr;
+    int64_t log_re;
+
+    bool operator==(const GridKey&) const = default;
+};
+
+struct GridKeyHash {
+    size_t operator()(const GridKey& key) const {
+        return hash<int64_t>()(key.tsr) ^
+               (hash<int64_t>()(key.log_re) * 0x9e3779b97f4a7c15ull);
+    }
+};
+
+/**
+ * @brief the wind speeds of a csv record, read line by line
+ *
+ * Lines before the first one with a number are skipped. After it a line
+ * without a number is a gap, it gives a NaN sample once another number
+ * follows, so gaps at the end of the record are dropped.
+ */
+class CsvRecord {
+  private:
+    ifstream& in;
+    size_t column;
+    bool started = false;
+    size_t blank = 0;
+    size_t gaps = 0;
+    optional<double> next;
+
+    /**
+     * @brief the number in the selected column of `line`, if any
+     *
+     * @param line
+     * @return optional<double>
+     */
+    optional<double> parse(const string& line) const {
+        size_t start = 0;
+        for (size_t c = 0; c < this->column && start != string::npos; c++) {
+            start = line.find(',', start);
+            start = (start == string::npos) ? start : start + 1;
+        }
+        if (start == string::npos) {
+            return nullopt;
+        }
+        // from_chars does not depend on the locale, unlike strtod
+        const char* begin = line.data() + start;
+        const char* end = line.data() + line.size();
+        while (begin != end && (*begin == ' ' || *begin == '\t')) {
+            begin++;
+        }
+        if (begin != end && *begin == '+') {
+            begin++;
+        }
+        double value;
+        auto [ptr, ec] = from_chars(begin, end, value);
+        return (ec == errc() && ptr != begin) ? optional(value) : nullopt;
+    }
+
+  public:
+    CsvRecord(ifstream& in, size_t column) : in(in), column(column) {}
+
+    /**
+     * @brief read up to `n` wind speeds
+     *
+     * @param n
+     * @param speed - output
+     */
+    void read(size_t n, vector<double>& speed) {
+        string line;
+        while (speed.size() < n) {
+            if (this->gaps > 0) {
+                speed.push_back(NAN);
+                this->gaps--;
+            } else if (this->next) {
+                speed.push_back(*this->next);
+                this->next.reset();
+            } else if (!getline(this->in, line)) {
+                return;
+            } else if (optional<double> value = this->parse(line)) {
+                this->next = value;
+                this->started = true;
+                this->gaps = this->blank;
+                this->blank = 0;
+            } else if (this->started) {
+                this->blank++;
+            }
+        }
+    }
+};
+
+/**
+ * @brief read up to `n` wind speeds from a binary record
+ *
+ * @param in
+ * @param n
+ * @param speed - output
+ */
+static void read_binary(ifstream& in, size_t n, vector<double>& speed) {
+    speed.resize(n);
+    in.read(reinterpret_cast<char*>(speed.data()), n * sizeof(double));
+    size_t bytes = in.gcount();
+    if (bytes % sizeof(double) != 0) {
+        throw "binary wind record ends with a partial sample";
+    }
+    speed.resize(bytes / sizeof(double));
+}
+
+/**
+ * @brief append `value` and a separator to `out`
+ *
+ * @param out
+ * @param value
+ * @param separator
+ */
+static void append_csv(string& out, double value, char separator) {
+    char buffer[32];
+    auto result = to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+    out.push_back(separator);
+}
+
+SeriesSummary WindSeriesSimulator::run(string_view input, SeriesFormat format,
+                                       const Sink& sink) const {
+    const YieldSettings& turbine = this->turbine;
+    if (!(turbine.area > 0.0) || !(turbine.re_per_speed > 0.0) ||
+        !(this->_radius > 0.0) || !(this->_time_step > 0.0) ||
+        (!this->_control && !(turbine.tsr > 0.0))) {
+        throw "a wind series needs a positive area, re_per_speed, radius, "
+              "time step and tsr or control law";
+    }
+    if (this->_chunk_size == 0 || this->_queue_depth == 0 ||
+        !(this->d_tsr > 0.0) || !(this->d_log_re > 0.0)) {
+        throw "a wind series needs a positive chunk size, queue depth and "
+              "resolution";
+    }
+    ifstream in(string(input), ios::binary);
+    if (!in) {
+        throw "could not read wind record";
+    }
+
+    BoundedQueue<SeriesChunk> read(this->_queue_depth);
+    BoundedQueue<SeriesChunk> converted(this->_queue_depth);
+    BoundedQueue<SeriesChunk> solved(this->_queue_depth);
+    mutex error_mutex;
+    exception_ptr error;
+    // runs a stage, the first error closes all queues so every stage stops
+    auto stage = [&](auto&& body) {
+        try {
+            body();
+        } catch (...) {
+            lock_guard lock(error_mutex);
+            if (!error) {
+                error = current_exception();
+            }
+            read.close();
+            converted.close();
+            solved.close();
+        }
+    };
+
+    thread reader([&]() {
+        stage([&]() {
+            size_t first = 0;
+            CsvRecord record(in, this->_column);
+            while (true) {
+                SeriesChunk chunk;
+                chunk.first = first;
+                chunk.speed.reserve(this->_chunk_size);
+                if (format == SeriesFormat::csv) {
+                    record.read(this->_chunk_size, chunk.speed);
+                } else {
+                    read_binary(in, this->_chunk_size, chunk.speed);
+                }
+                if (chunk.speed.empty()) {
+                    break;
+                }
+                first += chunk.size();
+                if (!read.push(std::move(chunk))) {
+                    return;
+                }
+            }
+        });
+        read.close();
+    });
+
+    thread converter([&]() {
+        stage([&]() {
+            SeriesChunk chunk;
+            while (read.pop(chunk)) {
+                size_t n = chunk.size();
+                chunk.tsr.assign(n, 0.0);
+                chunk.re.resize(n);
+                for (size_t i = 0; i < n; i++) {
+                    double speed = chunk.speed[i];
+                    chunk.re[i] = turbine.re_per_speed * speed;
+                    // the rotor is stopped out of the operating range
+                    if (!(speed >= turbine.cut_in && speed <= turbine.cut_out &&
+                          speed > 0.0)) {
+                        continue;
+                    }
+                    double tsr = this->_control ? this->_control(speed) *
+                                                      this->_radius / speed
+                                                : turbine.tsr;
+                    // or where the control law gives no usable rotor speed
+                    chunk.tsr[i] = (isfinite(tsr) && tsr > 0.0) ? tsr : 0.0;
+                }
+                if (!converted.push(std::move(chunk))) {
+                    return;
+                }
+            }
+        });
+        converted.close();
+    });
+
+    SeriesSummary summary{0, 0.0, 0.0, 0};
+    thread writer([&]() {
+        stage([&]() {
+            SeriesChunk chunk;
+            while (solved.pop(chunk)) {
+                // the chunks left in the queue after an error are dropped
+                {
+                    lock_guard lock(error_mutex);
+                    if (error) {
+                        return;
+                    }
+                }
+                for (double power : chunk.power) {
+                    summary.energy += power * this->_time_step / 3.6e6;
+                    summary.max_power = max(summary.max_power, power);
+                }
+                summary.samples += chunk.size();
+                sink(chunk);
+            }
+        });
+    });
+
+    // the solve stage runs on the calling thread, the cache is only touched
+    // here
+    stage([&]() {
+        unordered_map<GridKey, pair<double, double>, GridKeyHash> cache;
+        vector<GridKey> keys, missing;
+        vector<pair<double, double>> values;
+        SeriesChunk chunk;
+        while (converted.pop(chunk)) {
+            size_t n = chunk.size();
+            chunk.c_power.resize(n);
+            chunk.c_torque.resize(n);
+            if (this->map) {
+                this->map->eval(chunk.tsr, chunk.re, turbine.amplitude,
+                                chunk.c_power, chunk.c_torque);
+            } else {
+                keys.resize(n);
+                missing.clear();
+                for (size_t i = 0; i < n; i++) {
+                    if (chunk.tsr[i] <= 0.0) {
+                        continue;
+                    }
+                    keys[i] = {llround(chunk.tsr[i] / this->d_tsr),
+                               llround(log(chunk.re[i]) / this->d_log_re)};
+                    if (cache.try_emplace(keys[i], NAN, NAN).second) {
+                        missing.push_back(keys[i]);
+                    }
+                }
+                values.resize(missing.size());
+                this->_pool->parallel_for(missing.size(), [&](size_t k) {
+                    VAWTSolution solution;
+                    this->solver->solve_at(
+                        (double)missing[k].tsr * this->d_tsr,
+                        exp((double)missing[k].log_re * this->d_log_re),
+                        this->beta, solution);
+                    values[k] = {solution.c_power(), solution.c_torque()};
+                });
+                for (size_t k = 0; k < missing.size(); k++) {
+                    cache[missing[k]] = values[k];
+                }
+                summary.solves += missing.size();
+                for (size_t i = 0; i < n; i++) {
+                    auto [c_power, c_torque] = (chunk.tsr[i] > 0.0)
+                                                   ? cache[keys[i]]
+                                                   : pair(0.0, 0.0);
+                    chunk.c_power[i] = c_power;
+                    chunk.c_torque[i] = c_torque;
+                }
+            }
+
+            chunk.power.resize(n);
+            chunk.torque.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                double speed = chunk.speed[i];
+                if (chunk.tsr[i] <= 0.0) {
+                    chunk.c_power[i] = 0.0;
+                    chunk.c_torque[i] = 0.0;
+                    chunk.power[i] = 0.0;
+                    chunk.torque[i] = 0.0;
+                    continue;
+                }
+                double power = 0.5 * turbine.density * turbine.area *
+                               speed * speed * speed * chunk.c_power[i];
+                // a turbine that would need driving is stopped
+                power = clamp(power, 0.0, turbine.rated_power);
+                double omega = chunk.tsr[i] * speed / this->_radius;
+                chunk.power[i] = power;
+                chunk.torque[i] = power / omega;
+            }
+            if (!solved.push(std::move(chunk))) {
+                return;
+            }
+        }
+    });
+    solved.close();
+
+    reader.join();
+    converter.join();
+    writer.join();
+    if (error) {
+        rethrow_exception(error);
+    }
+    return summary;
+}
+
+SeriesSummary WindSeriesSimulator::run(string_view input,
+                                       SeriesFormat input_format,
+                                       string_view output,
+                                       SeriesFormat output_format) const {
+    SeriesSummary summary;
+    write_file(
+        output,
+        [&](ostream& out) {
+            if (output_format == SeriesFormat::csv) {
+                out << "speed,tsr,re,c_power,c_torque,power,torque\n";
+            }
+            string buffer;
+            vector<double> row;
+            auto sink = [&](const SeriesChunk& chunk) {
+                const vector<double>* columns[] = {
+                    &chunk.speed,   &chunk.tsr,      &chunk.re,
+                    &chunk.c_power, &chunk.c_torque, &chunk.power,
+                    &chunk.torque};
+                if (output_format == SeriesFormat::csv) {
+                    buffer.clear();
+                    for (size_t i = 0; i < chunk.size(); i++) {
+                        for (size_t c = 0; c < 7; c++) {
+                            append_csv(buffer, (*columns[c])[i],
+                                       c < 6 ? ',' : '\n');
+                        }
+                    }
+                    out.write(buffer.data(), buffer.size());
+                } else {
+                    row.resize(7 * chunk.size());
+                    for (size_t i = 0; i < chunk.size(); i++) {
+                        for (size_t c = 0; c < 7; c++) {
+                            row[7 * i + c] = (*columns[c])[i];
+                        }
+                    }
+                    out.write(reinterpret_cast<const char*>(row.data()),
+                              row.size() * sizeof(double));
+                }
+                if (!out) {
+                    throw "could not write power series";
+                }
+            };
+            summary = this->run(input, input_format, sink);
+        },
+        "could not write power series");
+    return summary;
+}
+
+} // namespace vawt
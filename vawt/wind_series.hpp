@@ -0,0 +1,308 @@
+#pragma once
+
+#include "performance_map.hpp"
+#include "thread_pool.hpp"
+#include "vawt.hpp"
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace vawt {
+
+/**
+ * @brief file format of a wind speed record or a power series
+ *
+ * - `csv` text, one sample per line. Lines before the first number in the
+ *   selected column (e.g. a header) are skipped, after it a line without a
+ *   number is a gap in the record: a NaN sample, for which the rotor is
+ *   stopped. Gaps at the end of the record are dropped.
+ * - `binary` native `double`s without a header, one per sample for a wind
+ *   speed record, see `WindSeriesSimulator::run` for a power series
+ */
+enum class SeriesFormat { csv, binary };
+
+/**
+ * @brief consecutive samples of a simulated power series
+ */
+struct SeriesChunk {
+    /**
+     * @brief index of the first sample in the record
+     */
+    size_t first = 0;
+
+    /**
+     * @brief wind speed in m/s
+     */
+    std::vector<double> speed;
+
+    /**
+     * @brief tip speed ratio set by the control law, 0 when stopped
+     */
+    std::vector<double> tsr;
+
+    /**
+     * @brief reynolds number of the turbine
+     */
+    std::vector<double> re;
+
+    /**
+     * @brief power coefficient
+     */
+    std::vector<double> c_power;
+
+    /**
+     * @brief torque coefficient
+     */
+    std::vector<double> c_torque;
+
+    /**
+     * @brief power in W, 0 outside of the cut in and cut out speed and
+     * capped at the rated power
+     */
+    std::vector<double> power;
+
+    /**
+     * @brief rotor torque in Nm, consistent with `power`
+     */
+    std::vector<double> torque;
+
+    size_t size() const { return this->speed.size(); }
+};
+
+/**
+ * @brief totals of a simulated power series
+ */
+struct SeriesSummary {
+    /**
+     * @brief number of samples
+     */
+    size_t samples;
+
+    /**
+     * @brief energy in kWh
+     */
+    double energy;
+
+    /**
+     * @brief largest power in W
+     */
+    double max_power;
+
+    /**
+     * @brief number of `VAWTSolver` solves, 0 with a `PerformanceMap`
+     */
+    size_t solves;
+};
+
+/**
+ * @brief simulate the power output of a turbine for a wind speed record
+ *
+ * The record is streamed in chunks through four stages connected by bounded
+ * queues: read, convert (the control law sets the tip speed ratio and
+ * reynolds number of each sample), solve and write. Each stage runs on its
+ * own thread, so reading and writing overlap with the solves, and no more
+ * than `chunk_size * (3 * queue_depth + 4)` samples are held in memory at
+ * any time, however long the record is. The chunks keep the order of the
+ * record.
+ *
+ * The coefficients are quasi steady, they come either from a
+ * `PerformanceMap` lookup or from solves of a `VAWTSolver`. The solves are
+ * made on demand at the tsr and log(re) rounded to a grid (see
+ * `resolution`), cached for the whole run and spread over the thread pool.
+ */
+class WindSeriesSimulator {
+  private:
+    std::optional<VAWTSolver> solver;
+    std::optional<PerformanceMap> map;
+    std::function<double(double)> beta = ConstantPitch(0.0);
+    YieldSettings turbine{};
+    double _radius = 1.0;
+    double _time_step = 1.0;
+    std::function<double(double)> _control;
+    size_t _column = 0;
+    size_t _chunk_size = 1 << 16;
+    size_t _queue_depth = 4;
+    double d_tsr = 0.01;
+    double d_log_re = 0.01;
+    ThreadPool* _pool = &ThreadPool::shared();
+
+  public:
+    /**
+     * @brief receives the chunks of a power series in order
+     *
+     * `Fn(chunk: const SeriesChunk&)`
+     */
+    using Sink = std::function<void(const SeriesChunk&)>;
+
+    /**
+     * @brief Construct a new WindSeriesSimulator with on demand solves
+     *
+     * @param solver - aerofoil and solve settings, its tsr and re are
+     * replaced by the samples
+     */
+    explicit WindSeriesSimulator(VAWTSolver solver)
+        : solver(std::move(solver)) {}
+
+    /**
+     * @brief Construct a new WindSeriesSimulator with map lookups
+     *
+     * @param map - at the pitch amplitude of `turbine`
+     */
+    explicit WindSeriesSimulator(PerformanceMap map) : map(std::move(map)) {}
+
+    /**
+     * @brief the turbine, its tsr is used by the default control law
+     *
+     * @param turbine
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& settings(const YieldSettings& turbine) {
+        this->turbine = turbine;
+        return *this;
+    }
+
+    /**
+     * @brief rotor radius in m, 1 by default
+     *
+     * @param radius
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& radius(double radius) {
+        this->_radius = radius;
+        return *this;
+    }
+
+    /**
+     * @brief time between two samples of the record in s, 1 by default
+     *
+     * @param dt
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& time_step(double dt) {
+        this->_time_step = dt;
+        return *this;
+    }
+
+    /**
+     * @brief rotor speed in rad/s as a function of the wind speed, the tsr
+     * of the settings by default
+     *
+     * The rotor is stopped where it is not finite and positive.
+     *
+     * @param control
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& control(std::function<double(double)> control) {
+        this->_control = std::move(control);
+        return *this;
+    }
+
+    /**
+     * @brief pitch angle as a function of theta for the solves, 0 by default
+     *
+     * Not used with a `PerformanceMap`, which is looked up at the pitch
+     * amplitude of the settings instead.
+     *
+     * @param beta
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& pitch(std::function<double(double)> beta) {
+        this->beta = std::move(beta);
+        return *this;
+    }
+
+    /**
+     * @brief the column of a csv record holding the wind speed, 0 by default
+     *
+     * @param column
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& column(size_t column) {
+        this->_column = column;
+        return *this;
+    }
+
+    /**
+     * @brief samples per chunk, 65536 by default
+     *
+     * @param n - at least 1
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& chunk_size(size_t n) {
+        this->_chunk_size = n;
+        return *this;
+    }
+
+    /**
+     * @brief chunks each queue between two stages holds, 4 by default
+     *
+     * @param n - at least 1
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& queue_depth(size_t n) {
+        this->_queue_depth = n;
+        return *this;
+    }
+
+    /**
+     * @brief grid spacing of the tsr and of log(re) the on demand solves are
+     * rounded to, 0.01 each by default
+     *
+     * @param d_tsr
+     * @param d_log_re
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& resolution(double d_tsr, double d_log_re) {
+        this->d_tsr = d_tsr;
+        this->d_log_re = d_log_re;
+        return *this;
+    }
+
+    /**
+     * @brief run the solves on `pool` instead of `ThreadPool::shared()`
+     *
+     * The pool must outlive the simulator.
+     *
+     * @param pool
+     * @return WindSeriesSimulator&
+     */
+    WindSeriesSimulator& pool(ThreadPool& pool) {
+        this->_pool = &pool;
+        return *this;
+    }
+
+    /**
+     * @brief simulate the record in `input` and pass each chunk to `sink`
+     *
+     * The sink is called from the write stage thread, one chunk at a time.
+     * The first exception of any stage, the sink included, stops the
+     * pipeline and is rethrown; the sink is not called again after it.
+     *
+     * @param input - wind speed record
+     * @param format - format of `input`
+     * @param sink
+     * @return SeriesSummary
+     */
+    SeriesSummary run(std::string_view input, SeriesFormat format,
+                      const Sink& sink) const;
+
+    /**
+     * @brief simulate the record in `input` and write the power series to
+     * `output`
+     *
+     * A csv series has the header `speed,tsr,re,c_power,c_torque,power,
+     * torque`. A binary series holds these 7 `double`s per sample.
+     *
+     * @param input - wind speed record
+     * @param input_format
+     * @param output
+     * @param output_format
+     * @return SeriesSummary
+     */
+    SeriesSummary run(std::string_view input, SeriesFormat input_format,
+                      std::string_view output,
+                      SeriesFormat output_format) const;
+};
+
+} // namespace vawt